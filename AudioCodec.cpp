@@ -0,0 +1,161 @@
+//
+// AudioCodec.cpp
+//
+// IMA ADPCM and G.711 mu-law codecs with frame header, see AudioCodec.h
+//
+// s60sc 2026
+
+#include "AudioCodec.h"
+#include <string.h>
+#include <limits.h>
+
+#define ULAW_BIAS 0x84
+#define ULAW_CLIP 32635
+
+static const int16_t imaStep[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 
+  253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 
+  1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 
+  3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 
+  12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+static const int8_t imaIndex[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+static inline int clamp(int val, int lo, int hi) {
+  return val < lo ? lo : val > hi ? hi : val;
+}
+
+static inline uint8_t ulawEncode(int16_t sample) {
+  int32_t val = sample;
+  uint8_t sign = val < 0 ? 0x80 : 0;
+  if (sign) val = -val;
+  if (val > ULAW_CLIP) val = ULAW_CLIP;
+  val += ULAW_BIAS;
+  int exponent = 7;
+  for (int32_t mask = 0x4000; !(val & mask) && exponent > 0; exponent--, mask >>= 1);
+  uint8_t mantissa = (val >> (exponent + 3)) & 0x0F;
+  return ~(sign | (exponent << 4) | mantissa);
+}
+
+static inline int16_t ulawDecode(uint8_t ulaw) {
+  ulaw = ~ulaw;
+  int exponent = (ulaw >> 4) & 0x07;
+  int32_t val = ((((int32_t)ulaw & 0x0F) << 3) + ULAW_BIAS) << exponent;
+  val -= ULAW_BIAS;
+  return (ulaw & 0x80) ? -val : val;
+}
+
+static inline uint8_t adpcmEncode(codecState* st, int16_t sample) {
+  // encode sample as 4 bit difference from prediction
+  int step = imaStep[st->stepIndex];
+  int diff = sample - st->predictor;
+  uint8_t nibble = 0;
+  if (diff < 0) {
+    nibble = 8;
+    diff = -diff;
+  }
+  int delta = step >> 3;
+  if (diff >= step) { nibble |= 4; diff -= step; delta += step; }
+  step >>= 1;
+  if (diff >= step) { nibble |= 2; diff -= step; delta += step; }
+  step >>= 1;
+  if (diff >= step) { nibble |= 1; delta += step; }
+  st->predictor = clamp(st->predictor + ((nibble & 8) ? -delta : delta), SHRT_MIN, SHRT_MAX);
+  st->stepIndex = clamp(st->stepIndex + imaIndex[nibble & 7], 0, 88);
+  return nibble;
+}
+
+static inline int16_t adpcmDecode(int16_t* predictor, int8_t* stepIndex, uint8_t nibble) {
+  // same calculation as encoder
+  int step = imaStep[*stepIndex];
+  int delta = step >> 3;
+  if (nibble & 4) delta += step;
+  if (nibble & 2) delta += step >> 1;
+  if (nibble & 1) delta += step >> 2;
+  *predictor = clamp(*predictor + ((nibble & 8) ? -delta : delta), SHRT_MIN, SHRT_MAX);
+  *stepIndex = clamp(*stepIndex + imaIndex[nibble & 7], 0, 88);
+  return *predictor;
+}
+
+size_t codecFrameLen(int codec, size_t numSamples) {
+  // size of frame including header
+  switch (codec) {
+    case codec_ulaw: return CODEC_HDR_LEN + numSamples;
+    case codec_adpcm: return CODEC_HDR_LEN + ADPCM_STATE_LEN + (numSamples + 1) / 2;
+    default: return CODEC_HDR_LEN + numSamples * sizeof(int16_t);
+  }
+}
+
+size_t codecEncode(codecState* st, int codec, const int16_t* samples, size_t numSamples, uint8_t* frame) {
+  // encode samples into frame, returns frame length
+  if (codec < 0 || codec >= CODEC_COUNT) codec = codec_pcm;
+  uint16_t sampleCnt = numSamples;
+  frame[0] = CODEC_TAG;
+  frame[1] = codec;
+  memcpy(frame + 2, &st->seq, 2);
+  memcpy(frame + 4, &st->timestamp, 4);
+  memcpy(frame + 8, &sampleCnt, 2);
+  st->seq++;
+  st->timestamp += numSamples;
+  uint8_t* out = frame + CODEC_HDR_LEN;
+  switch (codec) {
+    case codec_ulaw:
+      for (size_t i = 0; i < numSamples; i++) out[i] = ulawEncode(samples[i]);
+    break;
+    case codec_adpcm:
+      memcpy(out, &st->predictor, 2);
+      out[2] = st->stepIndex;
+      out[3] = 0;
+      out += ADPCM_STATE_LEN;
+      for (size_t i = 0; i < numSamples; i += 2) {
+        uint8_t lo = adpcmEncode(st, samples[i]);
+        uint8_t hi = i + 1 < numSamples ? adpcmEncode(st, samples[i + 1]) : 0;
+        *out++ = lo | (hi << 4);
+      }
+    break;
+    default:
+      memcpy(out, samples, numSamples * sizeof(int16_t));
+    break;
+  }
+  return codecFrameLen(codec, numSamples);
+}
+
+size_t codecDecode(codecState* st, const uint8_t* msg, size_t msgLen, int16_t* samples, size_t maxSamples) {
+  // decode each frame in message, returns number of samples
+  size_t sampleCnt = 0;
+  while (msgLen >= CODEC_HDR_LEN && msg[0] == CODEC_TAG) {
+    int codec = msg[1];
+    uint16_t seq, numSamples;
+    memcpy(&seq, msg + 2, 2);
+    memcpy(&numSamples, msg + 8, 2);
+    size_t frameLen = codecFrameLen(codec, numSamples);
+    if (codec >= CODEC_COUNT || frameLen > msgLen || sampleCnt + numSamples > maxSamples) break;
+    if (st->synced && seq != st->seq) st->lost += (uint16_t)(seq - st->seq);
+    st->seq = seq + 1;
+    st->synced = true;
+    const uint8_t* in = msg + CODEC_HDR_LEN;
+    int16_t* out = samples + sampleCnt;
+    switch (codec) {
+      case codec_ulaw:
+        for (size_t i = 0; i < numSamples; i++) out[i] = ulawDecode(in[i]);
+      break;
+      case codec_adpcm: {
+        int16_t predictor;
+        memcpy(&predictor, in, 2);
+        int8_t stepIndex = clamp(in[2], 0, 88);
+        in += ADPCM_STATE_LEN;
+        for (size_t i = 0; i < numSamples; i++) 
+          out[i] = adpcmDecode(&predictor, &stepIndex, (i & 1) ? in[i / 2] >> 4 : in[i / 2] & 0x0F);
+      }
+      break;
+      default:
+        memcpy(out, in, numSamples * sizeof(int16_t));
+      break;
+    }
+    sampleCnt += numSamples;
+    msg += frameLen;
+    msgLen -= frameLen;
+  }
+  return sampleCnt;
+}
@@ -0,0 +1,44 @@
+//
+// AudioCodec.h
+//
+// Framing and compression of browser mic and speaker audio over websocket.
+// Each frame has a header followed by the encoded samples:
+//   byte 0: CODEC_TAG
+//   byte 1: codec, one of audioCodec
+//   bytes 2-3: sequence number
+//   bytes 4-7: timestamp as count of samples
+//   bytes 8-9: number of samples
+// with multibyte values little endian. Payload for each codec:
+//   codec_pcm: 16 bit samples
+//   codec_ulaw: G.711 mu-law, 8 bits per sample, 2:1
+//   codec_adpcm: IMA ADPCM, initial predictor (int16) and step index (uint8) plus
+//     pad byte, then 4 bits per sample low nibble first, 4:1
+// ADPCM state is carried in each frame so a lost frame does not upset later ones.
+// A websocket message may contain several concatenated frames.
+// The browser side is in data/common.js.
+// No Arduino dependencies, so also built on the host by extras/udpIntercom.cpp
+//
+// s60sc 2026
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define CODEC_TAG 'A'
+#define CODEC_HDR_LEN 10
+#define ADPCM_STATE_LEN 4
+
+enum audioCodec {codec_pcm = 0, codec_ulaw, codec_adpcm, CODEC_COUNT};
+
+struct codecState {
+  uint16_t seq; // next sequence number sent or expected
+  uint32_t timestamp; // samples sent
+  int16_t predictor; // ADPCM
+  int8_t stepIndex;
+  uint32_t lost; // frames missing from received sequence
+  bool synced; // first frame received
+};
+
+size_t codecFrameLen(int codec, size_t numSamples);
+size_t codecEncode(codecState* st, int codec, const int16_t* samples, size_t numSamples, uint8_t* frame);
+size_t codecDecode(codecState* st, const uint8_t* msg, size_t msgLen, int16_t* samples, size_t maxSamples);
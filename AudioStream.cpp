@@ -0,0 +1,150 @@
+//
+// Live http stream of processed audio
+//
+// /stream.wav serves the filter chain output as an endless WAV stream using
+// chunked encoding, or with ?fmt=l16 as raw big endian L16, eg:
+//   ffplay http://<app_ip>/stream.wav
+//   curl http://<app_ip>/stream.wav?fmt=l16 -o voice.raw
+// Each output block is copied into a shared ring by the audio task, which never
+// waits on a listener. Each listener is served by its own task with its own read
+// cursor into the ring, and is dropped if it falls too far behind.
+// Silence is sent while no audio is being output, to keep players running.
+//
+// s60sc 2026
+
+#include "appGlobals.h"
+#include "WavConvert.h"
+#include <atomic>
+
+#define STREAM_RING_LEN (16 * 1024) // samples in shared ring, power of 2
+#define STREAM_CHUNK 1024 // max samples per chunk sent
+#define STREAM_IDLE_MS 200 // silence sent after this long without audio
+
+struct streamClient {
+  httpd_req_t* req; // async copy of request
+  TaskHandle_t task;
+  bool inUse;
+  bool l16; // raw big endian samples, else wav
+  char contentType[40]; // retained until headers sent by task
+};
+
+static int16_t* streamRing = NULL;
+static std::atomic<uint32_t> streamWritten(0); // total samples written to ring
+static std::atomic<int> streamListeners(0);
+static streamClient streamClients[MAX_STREAMS];
+static portMUX_TYPE streamMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t streamDropped = 0; // listeners dropped for being too slow
+
+void streamWrite(int16_t* samples, size_t numSamples) {
+  // called from audio task to add output block to ring and wake listeners
+  if (streamListeners.load() == 0 || streamRing == NULL) return;
+  uint32_t writePos = streamWritten.load() & (STREAM_RING_LEN - 1);
+  size_t firstLen = std::min(numSamples, (size_t)(STREAM_RING_LEN - writePos));
+  memcpy(streamRing + writePos, samples, firstLen * sizeof(int16_t));
+  memcpy(streamRing, samples + firstLen, (numSamples - firstLen) * sizeof(int16_t));
+  streamWritten.fetch_add(numSamples);
+  portENTER_CRITICAL(&streamMux);
+  for (int i = 0; i < MAX_STREAMS; i++) if (streamClients[i].task != NULL) xTaskNotifyGive(streamClients[i].task);
+  portEXIT_CRITICAL(&streamMux);
+}
+
+static void streamTask(void* arg) {
+  // send ring content to one listener as it arrives
+  streamClient* client = (streamClient*)arg;
+  int16_t* chunk = (int16_t*)malloc(STREAM_CHUNK * sizeof(int16_t));
+  portENTER_CRITICAL(&streamMux);
+  client->task = xTaskGetCurrentTaskHandle();
+  portEXIT_CRITICAL(&streamMux);
+  esp_err_t res = chunk == NULL ? ESP_FAIL : ESP_OK;
+  if (res == ESP_OK && !client->l16) {
+    uint8_t hdr[WAV_HDR_LEN];
+    makeWavHeader(hdr, SAMPLE_RATE, 0xFFFFFFFF);
+    res = httpd_resp_send_chunk(client->req, (char*)hdr, WAV_HDR_LEN);
+  }
+  uint32_t cursor = streamWritten.load(); // start from live audio
+  uint32_t idleTime = millis();
+  while (res == ESP_OK) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STREAM_IDLE_MS));
+    uint32_t avail = streamWritten.load() - cursor;
+    if (!avail) {
+      uint32_t idleMs = millis() - idleTime;
+      if (idleMs < STREAM_IDLE_MS) continue;
+      // no audio output, send silence for whole of idle period in chunks
+      size_t silence = (size_t)SAMPLE_RATE * idleMs / 1000;
+      memset(chunk, 0, STREAM_CHUNK * sizeof(int16_t));
+      while (silence && res == ESP_OK) {
+        size_t len = std::min(silence, (size_t)STREAM_CHUNK);
+        res = httpd_resp_send_chunk(client->req, (char*)chunk, len * sizeof(int16_t));
+        silence -= len;
+      }
+      idleTime += idleMs;
+      continue;
+    }
+    idleTime = millis();
+    while (avail && res == ESP_OK) {
+      size_t len = std::min(avail, (uint32_t)STREAM_CHUNK);
+      for (size_t i = 0; i < len; i++) {
+        int16_t sample = streamRing[(cursor + i) & (STREAM_RING_LEN - 1)];
+        chunk[i] = client->l16 ? __builtin_bswap16(sample) : sample;
+      }
+      // check copied samples not overwritten by block being written
+      if (streamWritten.load() + DMA_BUFF_LEN - cursor > STREAM_RING_LEN) {
+        LOG_WRN("Stream listener too slow, dropped %lu so far", ++streamDropped);
+        res = ESP_FAIL;
+        break;
+      }
+      res = httpd_resp_send_chunk(client->req, (char*)chunk, len * sizeof(int16_t));
+      cursor += len;
+      avail -= len;
+    }
+  }
+  LOG_INF("Stream listener %d disconnected", client - streamClients);
+  httpd_req_async_handler_complete(client->req);
+  free(chunk);
+  streamListeners--;
+  portENTER_CRITICAL(&streamMux);
+  client->task = NULL;
+  client->inUse = false;
+  portEXIT_CRITICAL(&streamMux);
+  vTaskDelete(NULL);
+}
+
+esp_err_t streamHandler(httpd_req_t* req) {
+  // start task to serve new listener, so web server is not held up
+  if (streamRing == NULL) {
+    streamRing = (int16_t*)(psramFound() ? ps_calloc(STREAM_RING_LEN, sizeof(int16_t)) : calloc(STREAM_RING_LEN, sizeof(int16_t)));
+    if (streamRing == NULL) {
+      LOG_WRN("Insufficient memory for audio stream");
+      return httpd_resp_send_500(req);
+    }
+  }
+  int slot = 0;
+  while (slot < MAX_STREAMS && streamClients[slot].inUse) slot++;
+  if (slot >= MAX_STREAMS) {
+    LOG_WRN("Max %d stream listeners already connected", MAX_STREAMS);
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_sendstr(req, "Too many listeners");
+  }
+  streamClient* client = &streamClients[slot];
+  char query[32] = {0};
+  char fmt[8] = {0};
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) httpd_query_key_value(query, "fmt", fmt, sizeof(fmt));
+  client->l16 = !strcmp(fmt, "l16");
+  if (httpd_req_async_handler_begin(req, &client->req) != ESP_OK) return ESP_FAIL;
+  if (client->l16) snprintf(client->contentType, sizeof(client->contentType), "audio/L16;rate=%lu;channels=1", SAMPLE_RATE);
+  else strcpy(client->contentType, "audio/wav");
+  httpd_resp_set_type(client->req, client->contentType);
+  httpd_resp_set_hdr(client->req, "Cache-Control", "no-store");
+  httpd_resp_set_hdr(client->req, "Access-Control-Allow-Origin", "*");
+  client->inUse = true;
+  streamListeners++;
+  if (xTaskCreate(streamTask, "streamTask", STREAM_STACK_SIZE, client, STREAM_PRI, NULL) != pdPASS) {
+    LOG_WRN("Failed to start stream task");
+    streamListeners--;
+    client->inUse = false;
+    httpd_req_async_handler_complete(client->req);
+    return ESP_FAIL;
+  }
+  LOG_INF("Stream listener %d connected as %s", slot, client->l16 ? "L16" : "WAV");
+  return ESP_OK;
+}
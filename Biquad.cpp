@@ -19,6 +19,10 @@
 #include <math.h>
 #include "Biquad.h"
 #include "appGlobals.h"
+#if __has_include("dsps_biquad.h")
+#include "dsps_biquad.h"
+#define USE_ESP_DSP
+#endif
 
 Biquad::Biquad() {
     type = bq_type_lowpass;
@@ -165,3 +169,73 @@ void Biquad::calcBiquad(void) {
       this->type, Fc, Q, peakGain, a0, a1, a2, b1, b2); // ordered to be consistent with other biquad class 
     return;
 }
+
+void Biquad::getCoefs(float* coefs) {
+    // numerator then denominator coefficients
+    coefs[0] = a0;
+    coefs[1] = a1;
+    coefs[2] = a2;
+    coefs[3] = b1;
+    coefs[4] = b2;
+}
+
+/*************************** BiquadBank *****************************/
+
+BiquadBank::BiquadBank() {
+    coefs = state = NULL;
+    numBands = 0;
+}
+
+BiquadBank::~BiquadBank() {
+    free(coefs);
+    free(state);
+}
+
+bool BiquadBank::init(int numBands) {
+    // allocate coefficients and state for required number of bands in internal RAM
+    free(coefs);
+    free(state);
+    this->numBands = 0;
+    coefs = (float*)heap_caps_calloc(numBands * 5, sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    state = (float*)heap_caps_calloc(numBands * 2, sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (coefs == NULL || state == NULL) {
+        LOG_WRN("Insufficient memory for %d band biquad bank", numBands);
+        return false;
+    }
+    this->numBands = numBands;
+    return true;
+}
+
+void BiquadBank::setBand(int band, int type, float Fc, float Q, float peakGainDB) {
+    // use Biquad to calculate coefficients for band
+    Biquad bq(type, Fc, Q, peakGainDB);
+    bq.getCoefs(coefs + band * 5);
+    state[band * 2] = state[band * 2 + 1] = 0;
+}
+
+void BiquadBank::reset() {
+    memset(state, 0, numBands * 2 * sizeof(float));
+}
+
+void BiquadBank::process(int band, const float* in, float* out, size_t len) {
+    // filter block of samples for given band
+    float* c = coefs + band * 5;
+    float* z = state + band * 2;
+#ifdef USE_ESP_DSP
+    // direct form II, so state differs from Biquad but coefficients are same
+    dsps_biquad_f32((float*)in, out, len, c, z);
+#else
+    // transposed direct form II, as Biquad::process()
+    float a0 = c[0], a1 = c[1], a2 = c[2], b1 = c[3], b2 = c[4];
+    float z1 = z[0], z2 = z[1];
+    for (size_t i = 0; i < len; i++) {
+        float x = in[i];
+        float y = x * a0 + z1;
+        z1 = x * a1 + z2 - b1 * y;
+        z2 = x * a2 - b2 * y;
+        out[i] = y;
+    }
+    z[0] = z1;
+    z[1] = z2;
+#endif
+}
@@ -42,6 +42,7 @@ public:
     void setFc(float Fc);
     void setPeakGain(float peakGainDB);
     void setBiquad(int type, float Fc, float Q, float peakGainDB);
+    void getCoefs(float* coefs);
     float process(float in);
     
 protected:
@@ -60,4 +61,24 @@ inline float Biquad::process(float in) {
     return out;
 }
 
+// s60sc 2026 bank of biquads applied a block at a time, eg for vocoder bands.
+// Coefficients and state held in arrays so each band is processed over a whole
+// block with coefficients kept in registers. Uses esp-dsp biquad if available,
+// which is vectorised on the ESP32-S3.
+class BiquadBank {
+public:
+    BiquadBank();
+    ~BiquadBank();
+    bool init(int numBands);
+    void setBand(int band, int type, float Fc, float Q, float peakGainDB);
+    void process(int band, const float* in, float* out, size_t len);
+    void reset();
+    int bands() { return numBands; }
+
+protected:
+    float* coefs; // a0, a1, a2, b1, b2 per band
+    float* state; // z1, z2 per band
+    int numBands;
+};
+
 #endif // Biquad_h
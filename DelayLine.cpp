@@ -0,0 +1,229 @@
+//
+// DelayLine.cpp
+//
+// Delay line engine and modulated delay effects: chorus, flanger, echo, slapback
+//
+// Each block is processed in chunks no longer than the shortest tap delay, so
+// that all history read by the taps for a chunk has already been written.
+// For each tap, the history covering its modulation range for the chunk is copied
+// from the (PSRAM) delay buffer into an internal RAM scratch buffer before the
+// per sample loop.
+//
+// s60sc 2026
+
+#include "DelayLine.h"
+
+static float lfoTable[LFO_TABLE_LEN + 1]; // extra entry for interpolation wrap
+static bool lfoInit = false;
+
+static void initLfoTable() {
+  // one cycle of sine wave shared by all LFOs
+  if (!lfoInit) {
+    for (int i = 0; i <= LFO_TABLE_LEN; i++) lfoTable[i] = sin(2 * M_PI * i / LFO_TABLE_LEN);
+    lfoInit = true;
+  }
+}
+
+static inline float lfoValue(uint32_t phase) {
+  // interpolated sine value for 32 bit phase
+  uint32_t idx = phase >> 24;
+  float frac = (float)(phase & 0xFFFFFF) / 16777216.0f;
+  return lfoTable[idx] + frac * (lfoTable[idx + 1] - lfoTable[idx]);
+}
+
+/*************************** DelayLine *****************************/
+
+DelayLine::DelayLine() {
+  buff = NULL;
+  mask = 0;
+  writePos = 0;
+}
+
+DelayLine::~DelayLine() {
+  free(buff);
+}
+
+bool DelayLine::init(size_t maxDelay, bool internal) {
+  // allocate power of 2 sized buffer able to hold maxDelay samples
+  // internal forces use of internal RAM, otherwise large buffers go in PSRAM
+  free(buff);
+  buff = NULL;
+  size_t buffLen = 1;
+  while (buffLen < maxDelay) buffLen <<= 1;
+  size_t buffBytes = buffLen * sizeof(float);
+  if (!internal && buffBytes > DL_PSRAM_MIN && psramFound()) buff = (float*)ps_calloc(buffLen, sizeof(float));
+  else buff = (float*)heap_caps_calloc(buffLen, sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (buff == NULL) {
+    LOG_WRN("Unable to allocate delay line of %s", fmtSize(buffBytes));
+    mask = writePos = 0;
+    return false;
+  }
+  mask = buffLen - 1;
+  writePos = 0;
+  return true;
+}
+
+void DelayLine::clear() {
+  if (buff != NULL) memset(buff, 0, capacity() * sizeof(float));
+  writePos = 0;
+}
+
+void DelayLine::fetch(float* dest, size_t delay, size_t len) {
+  // copy len samples starting delay samples before current write position
+  size_t readPos = (writePos - delay) & mask;
+  size_t firstPart = std::min(len, capacity() - readPos);
+  memcpy(dest, buff + readPos, firstPart * sizeof(float));
+  if (len > firstPart) memcpy(dest + firstPart, buff, (len - firstPart) * sizeof(float));
+}
+
+void DelayLine::push(const float* src, size_t len) {
+  // append len samples at current write position
+  size_t firstPart = std::min(len, capacity() - writePos);
+  memcpy(buff + writePos, src, firstPart * sizeof(float));
+  if (len > firstPart) memcpy(buff, src + firstPart, (len - firstPart) * sizeof(float));
+  writePos = (writePos + len) & mask;
+}
+
+/*************************** DelayEffect *****************************/
+
+DelayEffect::DelayEffect() {
+  tapCnt = 0;
+  scratch = wetBuff = inBuff = NULL;
+}
+
+DelayEffect::~DelayEffect() {
+  free(scratch);
+  free(wetBuff);
+  free(inBuff);
+}
+
+void DelayEffect::addTap(float delayMs, float depthMs, float lfoHz, float gain) {
+  // add tap with given center delay, modulation depth & rate
+  if (tapCnt < DL_MAX_TAPS) {
+    delayTap& tap = taps[tapCnt++];
+    tap.delay = delayMs * sRate / 1000.0;
+    tap.depth = depthMs * sRate / 1000.0;
+    tap.gain = gain;
+    tap.phase = (uint32_t)(tapCnt * (UINT32_MAX / DL_MAX_TAPS)); // spread tap phases
+    tap.phaseInc = (uint32_t)(lfoHz / sRate * 4294967296.0);
+    tap.apState = 0;
+  }
+}
+
+bool DelayEffect::init(int preset, float mix, uint32_t sampleRate) {
+  // setup taps for required preset and allocate buffers
+  initLfoTable();
+  sRate = sampleRate;
+  tapCnt = 0;
+  wetMix = mix;
+  switch (preset) {
+    case dl_preset_chorus:
+      // several slowly modulated voices around 20ms
+      addTap(20, 2.5, 0.31, 0.5);
+      addTap(25, 3, 0.53, 0.4);
+      addTap(30, 2, 0.77, 0.3);
+      feedback = 0;
+      interp = dl_interp_linear;
+    break;
+    case dl_preset_flanger:
+      // single short swept delay with feedback
+      addTap(3, 2, 0.25, 0.7);
+      feedback = 0.6;
+      interp = dl_interp_allpass;
+    break;
+    case dl_preset_echo:
+      // multi tap echo with decaying repeats
+      addTap(250, 0, 0, 0.6);
+      addTap(500, 0, 0, 0.4);
+      addTap(750, 0, 0, 0.25);
+      feedback = 0.3;
+      interp = dl_interp_none;
+    break;
+    case dl_preset_slapback:
+    default:
+      addTap(110, 0, 0, 0.6);
+      feedback = 0;
+      interp = dl_interp_none;
+    break;
+  }
+  // determine delay range covered by taps
+  float maxDelay = 0;
+  minDelay = FLT_MAX;
+  maxSpan = 0;
+  for (int t = 0; t < tapCnt; t++) {
+    minDelay = std::min(minDelay, taps[t].delay - taps[t].depth);
+    maxDelay = std::max(maxDelay, taps[t].delay + taps[t].depth);
+    maxSpan = std::max(maxSpan, 2 * taps[t].depth);
+  }
+  if (minDelay < 2) minDelay = 2;
+
+  free(scratch);
+  free(wetBuff);
+  free(inBuff);
+  size_t scratchLen = DMA_BUFF_LEN + (size_t)maxSpan + 4;
+  scratch = (float*)heap_caps_malloc(scratchLen * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  wetBuff = (float*)heap_caps_malloc(DMA_BUFF_LEN * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  inBuff = (float*)heap_caps_malloc(DMA_BUFF_LEN * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (scratch == NULL || wetBuff == NULL || inBuff == NULL || !line.init((size_t)maxDelay + 2)) {
+    LOG_WRN("Insufficient memory for delay effect");
+    tapCnt = 0;
+    return false;
+  }
+  LOG_INF("Delay effect preset %d using %d taps, buffer %u samples", preset, tapCnt, line.capacity());
+  return true;
+}
+
+void DelayEffect::processChunk(float* in, size_t len) {
+  // apply taps to chunk of input samples, where len is less than shortest delay
+  memset(wetBuff, 0, len * sizeof(float));
+  for (int t = 0; t < tapCnt; t++) {
+    delayTap& tap = taps[t];
+    // prefetch history covering tap modulation range for this chunk
+    size_t back = (size_t)(tap.delay + tap.depth) + 1;
+    size_t span = std::min(back, len + (size_t)(2 * tap.depth) + 3);
+    line.fetch(scratch, back, span);
+
+    for (size_t j = 0; j < len; j++) {
+      float delay = tap.delay;
+      if (tap.phaseInc) {
+        delay += tap.depth * lfoValue(tap.phase);
+        tap.phase += tap.phaseInc;
+      }
+      // position of delayed sample relative to start of scratch
+      float readPos = (float)(back + j) - delay;
+      int ip = (int)readPos;
+      float frac = readPos - ip;
+      float val;
+      switch (interp) {
+        case dl_interp_linear:
+          val = scratch[ip] + frac * (scratch[ip + 1] - scratch[ip]);
+        break;
+        case dl_interp_allpass:
+          // first order allpass, coefficient from fractional delay
+          val = scratch[ip] + (frac / (2.0f - frac)) * (scratch[ip + 1] - tap.apState);
+          tap.apState = val;
+        break;
+        default:
+          val = scratch[frac < 0.5f ? ip : ip + 1];
+        break;
+      }
+      wetBuff[j] += tap.gain * val;
+    }
+  }
+  // write input plus feedback to delay line, then mix wet signal into output
+  for (size_t j = 0; j < len; j++) scratch[j] = in[j] + feedback * wetBuff[j];
+  line.push(scratch, len);
+  for (size_t j = 0; j < len; j++) in[j] += wetMix * wetBuff[j];
+}
+
+void DelayEffect::process(int16_t* samples, size_t numSamples) {
+  // apply delay effect in place to block of samples
+  if (!tapCnt) return;
+  size_t chunkLen = std::min((size_t)DMA_BUFF_LEN, (size_t)minDelay - 1);
+  for (size_t i = 0; i < numSamples; i += chunkLen) {
+    size_t len = std::min(chunkLen, numSamples - i);
+    for (size_t j = 0; j < len; j++) inBuff[j] = (float)samples[i + j];
+    processChunk(inBuff, len);
+    for (size_t j = 0; j < len; j++) samples[i + j] = (int16_t)constrain((int32_t)inBuff[j], SHRT_MIN, SHRT_MAX);
+  }
+}
@@ -0,0 +1,79 @@
+//
+// DelayLine.h
+//
+// Generic delay line engine used for time based effects:
+// - power of two circular buffer indexed by mask, held in PSRAM if long
+// - history needed by each tap is prefetched into internal RAM a chunk at a time,
+//   so PSRAM latency is not incurred in the per sample loop
+// - fractional read taps using linear or allpass interpolation, modulated by LFO
+//
+// s60sc 2026
+
+#pragma once
+#include "appGlobals.h"
+
+#define DL_MAX_TAPS 4 // max taps per delay effect
+#define DL_PSRAM_MIN (16 * 1024) // delay buffers larger than this are stored in PSRAM if available
+#define LFO_TABLE_LEN 256 // indexed by top 8 bits of LFO phase
+
+enum {
+  dl_interp_none = 0,
+  dl_interp_linear,
+  dl_interp_allpass
+};
+
+enum {
+  dl_preset_chorus = 0,
+  dl_preset_flanger,
+  dl_preset_echo,
+  dl_preset_slapback
+};
+
+class DelayLine {
+public:
+  DelayLine();
+  ~DelayLine();
+  bool init(size_t maxDelay, bool internal = false);
+  void clear();
+  void fetch(float* dest, size_t delay, size_t len);
+  void push(const float* src, size_t len);
+  size_t capacity() { return mask + 1; }
+
+protected:
+  float* buff;
+  size_t mask;
+  size_t writePos;
+};
+
+class DelayEffect {
+public:
+  DelayEffect();
+  ~DelayEffect();
+  bool init(int preset, float mix, uint32_t sampleRate);
+  void process(int16_t* samples, size_t numSamples);
+
+protected:
+  struct delayTap {
+    float delay;      // center delay in samples
+    float depth;      // modulation depth in samples
+    float gain;       // tap output gain
+    uint32_t phase;   // LFO phase accumulator
+    uint32_t phaseInc;
+    float apState;    // allpass interpolator state
+  };
+  void addTap(float delayMs, float depthMs, float lfoHz, float gain);
+  void processChunk(float* in, size_t len);
+
+  DelayLine line;
+  delayTap taps[DL_MAX_TAPS];
+  int tapCnt;
+  int interp;
+  float feedback;
+  float wetMix;
+  float minDelay;   // smallest delay of any tap, limits chunk length
+  float maxSpan;    // largest delay range of any tap
+  uint32_t sRate;
+  float* scratch;   // prefetched history for current tap
+  float* wetBuff;   // accumulated tap output for current chunk
+  float* inBuff;
+};
@@ -32,6 +32,7 @@ void setup() {
     setupAudioLed();
     prepPeripherals();
     setupVC();
+    prepIntercom();
 #if INCLUDE_RTSP
     prepRTSP();
 #endif
@@ -0,0 +1,133 @@
+//
+// FDNReverb.cpp
+//
+// Feedback delay network reverb, see FDNReverb.h
+//
+// Delay lines are allocated shortest first in internal RAM until
+// FDN_SRAM_BUDGET is used, remaining lines are placed in PSRAM.
+//
+// s60sc 2026
+
+#include "FDNReverb.h"
+
+// base line delays in ms for room size 1.0, chosen to avoid common factors
+static const float baseDelayMs[FDN_LINES] = {31.3, 37.9, 41.9, 47.3, 53.3, 59.9, 67.1, 73.7};
+
+static bool isPrime(size_t val) {
+  if (val < 2) return false;
+  for (size_t i = 2; i * i <= val; i++) if (val % i == 0) return false;
+  return true;
+}
+
+static inline void hadamard(float* vals) {
+  // in place fast Walsh-Hadamard transform, normalised so matrix is orthogonal
+  for (int h = 1; h < FDN_LINES; h <<= 1) {
+    for (int i = 0; i < FDN_LINES; i += h << 1) {
+      for (int j = i; j < i + h; j++) {
+        float a = vals[j];
+        float b = vals[j + h];
+        vals[j] = a + b;
+        vals[j + h] = a - b;
+      }
+    }
+  }
+  static const float norm = 1.0 / sqrt(FDN_LINES);
+  for (int i = 0; i < FDN_LINES; i++) vals[i] *= norm;
+}
+
+FDNReverb::FDNReverb() {
+  ready = false;
+  lineBuff = inBuff = NULL;
+}
+
+FDNReverb::~FDNReverb() {
+  free(lineBuff);
+  free(inBuff);
+}
+
+bool FDNReverb::init(float roomSize, float rt60, float damping, uint32_t sampleRate) {
+  // size delay lines for room size at given sample rate, and set decay and damping
+  ready = false;
+  damp = constrain(damping, 0.0, 0.95);
+  size_t minLen = SIZE_MAX;
+  for (int i = 0; i < FDN_LINES; i++) {
+    // use prime length so lines do not share echo times
+    size_t len = (size_t)(baseDelayMs[i] * roomSize * sampleRate / 1000.0);
+    if (len < 2) len = 2;
+    while (!isPrime(len)) len++;
+    lineLen[i] = len;
+    // gain for 60dB attenuation after rt60 seconds
+    lineGain[i] = pow(10.0, -3.0 * len / (rt60 * sampleRate));
+    lpState[i] = 0;
+    minLen = std::min(minLen, len);
+  }
+  chunkLen = std::min((size_t)FDN_CHUNK, minLen);
+
+  free(lineBuff);
+  free(inBuff);
+  lineBuff = (float*)heap_caps_malloc(FDN_LINES * FDN_CHUNK * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  inBuff = (float*)heap_caps_malloc(FDN_CHUNK * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (lineBuff == NULL || inBuff == NULL) {
+    LOG_WRN("Insufficient memory for reverb");
+    return false;
+  }
+  // line lengths increase with index, so allocate internal RAM to shortest lines first
+  size_t sramUsed = 0, psramUsed = 0;
+  for (int i = 0; i < FDN_LINES; i++) {
+    size_t buffLen = 1;
+    while (buffLen < lineLen[i] + 1) buffLen <<= 1;
+    bool internal = sramUsed + buffLen * sizeof(float) <= FDN_SRAM_BUDGET;
+    if (!lines[i].init(lineLen[i] + 1, internal)) {
+      LOG_WRN("Insufficient memory for reverb delay line %d", i);
+      return false;
+    }
+    if (internal) sramUsed += buffLen * sizeof(float);
+    else psramUsed += buffLen * sizeof(float);
+  }
+  LOG_INF("FDN reverb lines %u to %u samples, RT60 %0.1fs, using %s internal RAM, %s PSRAM",
+    lineLen[0], lineLen[FDN_LINES - 1], rt60, fmtSize(sramUsed), fmtSize(psramUsed));
+  ready = true;
+  return true;
+}
+
+void FDNReverb::clear() {
+  for (int i = 0; i < FDN_LINES; i++) {
+    lines[i].clear();
+    lpState[i] = 0;
+  }
+}
+
+void FDNReverb::processChunk(float* in, size_t len) {
+  // len is no longer than shortest line, so whole chunk of line outputs is already available
+  for (int i = 0; i < FDN_LINES; i++) lines[i].fetch(lineBuff + i * FDN_CHUNK, lineLen[i], len);
+
+  static const float wetGain = FDN_WET / sqrt(FDN_LINES);
+  float vals[FDN_LINES];
+  for (size_t j = 0; j < len; j++) {
+    float wet = 0;
+    for (int i = 0; i < FDN_LINES; i++) {
+      float out = lineBuff[i * FDN_CHUNK + j];
+      // alternate signs on output taps to reduce coloration
+      wet += (i & 1) ? -out : out;
+      // damp high frequencies and apply decay gain in feedback path
+      lpState[i] = out + damp * (lpState[i] - out);
+      vals[i] = lpState[i] * lineGain[i];
+    }
+    hadamard(vals);
+    // replace line output with next line input
+    for (int i = 0; i < FDN_LINES; i++) lineBuff[i * FDN_CHUNK + j] = in[j] + vals[i];
+    in[j] += wetGain * wet;
+  }
+  for (int i = 0; i < FDN_LINES; i++) lines[i].push(lineBuff + i * FDN_CHUNK, len);
+}
+
+void FDNReverb::process(int16_t* samples, size_t numSamples) {
+  // apply reverb in place to block of samples
+  if (!ready) return;
+  for (size_t i = 0; i < numSamples; i += chunkLen) {
+    size_t len = std::min(chunkLen, numSamples - i);
+    for (size_t j = 0; j < len; j++) inBuff[j] = (float)samples[i + j];
+    processChunk(inBuff, len);
+    for (size_t j = 0; j < len; j++) samples[i + j] = (int16_t)constrain((int32_t)inBuff[j], SHRT_MIN, SHRT_MAX);
+  }
+}
@@ -0,0 +1,42 @@
+//
+// FDNReverb.h
+//
+// Feedback delay network reverb:
+// - 8 delay lines of mutually prime lengths, scaled by room size and sample rate
+// - feedback mixed by normalised Hadamard matrix, computed as fast Walsh-Hadamard transform
+// - per line gain derived from required RT60 decay time
+// - per line one pole lowpass in feedback path to damp high frequencies
+// - processed in chunks no longer than the shortest line, so each line
+//   output for the chunk is read from the delay buffer in one block copy
+//
+// s60sc 2026
+
+#pragma once
+#include "DelayLine.h"
+
+#define FDN_LINES 8 // number of delay lines, must be power of 2 for Hadamard matrix
+#define FDN_CHUNK 256 // max samples per processing chunk
+#define FDN_SRAM_BUDGET (32 * 1024) // max bytes of internal RAM used for delay lines
+#define FDN_WET 0.35 // level of reverb mixed with input
+
+class FDNReverb {
+public:
+  FDNReverb();
+  ~FDNReverb();
+  bool init(float roomSize, float rt60, float damping, uint32_t sampleRate);
+  void process(int16_t* samples, size_t numSamples);
+  void clear();
+
+protected:
+  void processChunk(float* in, size_t len);
+
+  DelayLine lines[FDN_LINES];
+  size_t lineLen[FDN_LINES];  // delay of each line in samples
+  float lineGain[FDN_LINES];  // feedback gain giving required decay
+  float lpState[FDN_LINES];   // damping filter state
+  float damp;
+  size_t chunkLen;
+  bool ready;
+  float* lineBuff;  // FDN_LINES * FDN_CHUNK samples of line outputs then inputs
+  float* inBuff;
+};
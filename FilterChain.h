@@ -0,0 +1,62 @@
+//
+// FilterChain.h
+//
+// Instance of the voice changer processing chain, see Filters.cpp.
+// The live chain applied to sampleBuffer by applyFilters() is one instance,
+// an offline render uses its own instance so it can run alongside live audio.
+// Effect settings are taken from the web filter parameters when setup() is called.
+//
+// s60sc 2026
+
+#pragma once
+#include "appGlobals.h"
+#include "Biquad.h"
+#include "DelayLine.h"
+#include "FDNReverb.h"
+#include "Vocoder.h"
+#include "smbPitchShift.h"
+
+#define MAX_FILTERS 10
+
+#if CONFIG_IDF_TARGET_ESP32S3 && __has_include("dsps_mul.h")
+#define OUT_ESP_DSP // output stage gain uses esp-dsp vector multiply
+#endif
+
+class FilterChain {
+public:
+  FilterChain(bool isLive = false);
+  ~FilterChain();
+  void setup(uint32_t sampleRate);
+  void process(int16_t* samples, size_t numSamples); // numSamples <= DMA_BUFF_LEN
+
+protected:
+  void clearBiquads();
+  void initBiquad(int ftype, float freq, float Qval, float gain, int cascade);
+  void generateSineWave(uint16_t frequency, uint8_t amplitude);
+  bool initComb();
+  void initShaper();
+  inline float ditherNoise();
+  void outputStage(int16_t* samples, size_t numSamples);
+
+  bool live; // profile, apply volume
+  uint32_t rate;
+  Biquad* filter[MAX_FILTERS];
+  int filtIdx;
+  int8_t* sineWaveTable;
+  uint32_t dataPoints, sinePtr;
+  DelayEffect delayEffect;
+  FDNReverb fdnReverb;
+  Vocoder vocoder;
+  bool vocoderOn, delayOn, reverbOn, stftOn;
+  int reverbType;
+  int16_t* combBuff;
+  size_t combLen, combPtr;
+  float shaperTable[SHAPER_LEN + 1]; // clipping curve over input -1 .. 1
+  int shaperFactor; // clip factor used for table
+  float outGain; // current volume gain, ramped towards target
+  uint32_t ditherSeed;
+#ifdef OUT_ESP_DSP
+  float* vecBuff; // samples then gain ramp, each DMA_BUFF_LEN, for vector output stage
+#endif
+  smbState stft; // pitch shift and noise suppression
+};
@@ -11,9 +11,16 @@
 //     https://arachnoid.com/BiQuadDesigner/index.html
 //
 // s60sc 2021
+//
+// Chain state is held in a FilterChain instance, so that an offline render can
+// run its own chain while the live chain processes sampleBuffer.
+// s60sc 2026
 
-#include "appGlobals.h"
-#include "Biquad.h"
+#include "FilterChain.h"
+#include "dspProfile.h"
+#ifdef OUT_ESP_DSP
+#include "dsps_mul.h"
+#endif
 
 // web filter parameters
 bool RING_MOD;
@@ -25,6 +32,10 @@ bool LOW_SHELF;
 bool PEAK;
 bool CLIPPING;
 bool REVERB;
+bool DELAY_LINE;
+bool NOISE_SUPP;
+bool VOCODER;
+bool DITHER;
 float BP_Q;    // sharpness of filter
 float BP_FREQ; // center frequency for band pass
 uint16_t BP_CAS; // number of cascaded filters
@@ -46,14 +57,22 @@ uint8_t SW_AMP;    // amplitude of generated sine wave
 int CLIP_FACTOR; // factor used to clip higher amplitudes
 int DECAY_FACTOR; // factor used control reverb decay
 float PITCH_SHIFT; // factor used shift pitch up or down
+int DELAY_TYPE; // delay effect preset: chorus, flanger, echo, slapback
+int DELAY_MIX; // level of delayed signal mixed with input
+int RV_TYPE; // reverb type: 0 = single comb, 1 = feedback delay network
+int RV_SIZE; // FDN reverb room size
+int RV_DAMP; // FDN reverb high frequency damping
+uint32_t reverbTime = 0; // smoothed reverb processing time per block in us
+int NS_LEVEL; // noise suppression level, sets max attenuation
+int VOC_BANDS; // number of vocoder bands
+int VOC_CARRIER; // vocoder carrier: sawtooth, noise or recording
+int VOC_FREQ; // vocoder sawtooth carrier frequency
+uint32_t vocoderTime = 0; // smoothed vocoder processing time per block in us
+int vocoderBands = 0; // bands used by live vocoder after constraint
 
 // local definitions
-static const int MAX_FILTERS = 10;
-static Biquad *filter[MAX_FILTERS];
-static int filtIdx = 0;
-static int8_t* sineWaveTable;
-static uint32_t dataPoints;
 static float Qvals[40];
+static FilterChain liveChain(true);
 
 static int factorial(int top) {
   int fact = 0;
@@ -61,16 +80,6 @@ static int factorial(int top) {
   return fact;
 }
 
-static void generateSineWave(uint16_t frequency, uint8_t amplitude) {
-  // pre generate sine wave table at given frequency
-  dataPoints = SAMPLE_RATE / frequency; // number of data points for given freq
-  sineWaveTable = (int8_t*)malloc(dataPoints);
-  for (int i = 0; i < dataPoints; i++) {
-    sineWaveTable[i] = static_cast<int8_t>(sin(M_PI * 2 * frequency * i / SAMPLE_RATE) * amplitude);
-  }
-  LOG_INF("Generated %i sine wave data points", dataPoints);
-}
-
 static void calcQvals() {
   // calculate ideal Q vals for sequence of cascaded high or low pass filters
   // cascades is number of cascaded biquads
@@ -80,7 +89,7 @@ static void calcQvals() {
   }
 }
 
-static float nyquist(float freq, uint16_t srate) {
+static float nyquist(float freq, uint32_t srate) {
   float retval = freq / (float)srate;
   if (retval > 0.5) {
     retval = 0.5;
@@ -89,19 +98,149 @@ static float nyquist(float freq, uint16_t srate) {
   return retval;
 }
 
-static inline void initBiquad(int ftype, float freq, float Qval, float gain, int cascade) {
-  float cutoff = nyquist(freq, SAMPLE_RATE);
+FilterChain::FilterChain(bool isLive) {
+  live = isLive;
+  rate = SAMPLE_RATE;
+  memset(filter, 0, sizeof(filter));
+  filtIdx = 0;
+  sineWaveTable = NULL;
+  dataPoints = sinePtr = 0;
+  vocoderOn = delayOn = reverbOn = stftOn = false;
+  reverbType = 0;
+  combBuff = NULL;
+  combLen = combPtr = 0;
+  shaperFactor = -1;
+  outGain = 1.0;
+  ditherSeed = 22222;
+#ifdef OUT_ESP_DSP
+  vecBuff = NULL;
+#endif
+  memset(&stft, 0, sizeof(stft));
+}
+
+FilterChain::~FilterChain() {
+  clearBiquads();
+  free(sineWaveTable);
+  free(combBuff);
+#ifdef OUT_ESP_DSP
+  heap_caps_free(vecBuff);
+#endif
+  smbPitchShiftFree(&stft);
+}
+
+void FilterChain::clearBiquads() {
+  // release biquads from previous setup
+  for (int k = 0; k < filtIdx; k++) delete filter[k];
+  filtIdx = 0;
+}
+
+void FilterChain::generateSineWave(uint16_t frequency, uint8_t amplitude) {
+  // pre generate sine wave table at given frequency
+  dataPoints = rate / frequency; // number of data points for given freq
+  sinePtr = 0;
+  free(sineWaveTable);
+  sineWaveTable = (int8_t*)malloc(dataPoints);
+  if (sineWaveTable == NULL) {
+    LOG_WRN("Insufficient memory for ring modulator");
+    return;
+  }
+  for (uint32_t i = 0; i < dataPoints; i++) {
+    sineWaveTable[i] = static_cast<int8_t>(sin(M_PI * 2 * frequency * i / rate) * amplitude);
+  }
+  if (live) LOG_INF("Generated %i sine wave data points", dataPoints);
+}
+
+bool FilterChain::initComb() {
+  // single comb filter reverb, length scaled to sample rate
+  // comb only used if this succeeds, as length must match allocated buffer
+  size_t newLen = rate * REVERB_MS / 1000;
+  int16_t* newBuff = newLen ? (int16_t*)realloc(combBuff, newLen * sizeof(int16_t)) : NULL;
+  if (newBuff == NULL) {
+    LOG_WRN("Insufficient memory for reverb");
+    return false;
+  }
+  combBuff = newBuff;
+  combLen = newLen;
+  memset(combBuff, 0, combLen * sizeof(int16_t));
+  combPtr = 0;
+  return true;
+}
+
+void FilterChain::initShaper() {
+  // tabulate soft clip curve, clip factor: 1 = soft clip, 10 = hard clip
+  shaperFactor = CLIP_FACTOR;
+  float clipFactor = 1 + CLIP_FACTOR / 6.0;
+  for (int i = 0; i <= SHAPER_LEN; i++) {
+    float c = (2.0 * i / SHAPER_LEN - 1) * clipFactor;
+    shaperTable[i] = 1 / clipFactor * (c / (1.0 + 0.28 * (c * c)));
+  }
+}
+
+inline float FilterChain::ditherNoise() {
+  // uniform noise of +/- 0.5 LSB from xorshift32
+  ditherSeed ^= ditherSeed << 13;
+  ditherSeed ^= ditherSeed >> 17;
+  ditherSeed ^= ditherSeed << 5;
+  return (int32_t)ditherSeed / 4294967296.0f;
+}
+
+void FilterChain::outputStage(int16_t* samples, size_t numSamples) {
+  // single pass to apply volume, clipping and dither, then saturate back to int16
+  // volume only applies to live output
+  float targetGain = live ? getVolumeGain() : 1.0;
+  bool clip = CLIPPING && !DISABLE;
+  if (clip && CLIP_FACTOR != shaperFactor) initShaper(); // as can be changed while running
+  if (targetGain == 1.0 && outGain == 1.0 && !clip && !DITHER) return;
+  // gain change ramped over block, exponentially so that it is linear in dB
+  float gainStep = targetGain == outGain ? 1.0 : pow(targetGain / outGain, 1.0 / numSamples);
+  float gain = outGain;
+#ifdef OUT_ESP_DSP
+  if (!clip && !DITHER && vecBuff != NULL) {
+    // gain only, as vector multiply on ESP32-S3, giving same output as scalar loop below
+    float* vals = vecBuff;
+    float* ramp = vecBuff + DMA_BUFF_LEN;
+    for (size_t i = 0; i < numSamples; i++) vals[i] = samples[i];
+    if (gainStep == 1.0) dsps_mulc_f32(vals, vals, numSamples, gain, 1, 1);
+    else {
+      for (size_t i = 0; i < numSamples; i++) ramp[i] = gain *= gainStep;
+      dsps_mul_f32(vals, ramp, vals, numSamples, 1, 1, 1);
+    }
+    for (size_t i = 0; i < numSamples; i++) samples[i] = (int16_t)constrain(lrintf(vals[i]), SHRT_MIN, SHRT_MAX);
+    outGain = targetGain;
+    return;
+  }
+#endif
+  for (size_t i = 0; i < numSamples; i++) {
+    gain *= gainStep;
+    float outVal = samples[i] * gain;
+    if (clip) {
+      // interpolate waveshaper table
+      float pos = (constrain(outVal / SHRT_MAX, -1.0f, 1.0f) + 1) * (SHAPER_LEN / 2);
+      int idx = std::min((int)pos, SHAPER_LEN - 1);
+      outVal = SHRT_MAX * (shaperTable[idx] + (pos - idx) * (shaperTable[idx + 1] - shaperTable[idx]));
+    }
+    // triangular pdf dither of +/- 1 LSB
+    if (DITHER) outVal += ditherNoise() + ditherNoise();
+    samples[i] = (int16_t)constrain(lrintf(outVal), SHRT_MIN, SHRT_MAX);
+  }
+  outGain = targetGain;
+}
+
+void FilterChain::initBiquad(int ftype, float freq, float Qval, float gain, int cascade) {
+  float cutoff = nyquist(freq, rate);
   // if only one filter use user requested Qval, else use predefined Q values for Butterworth response
   int iOffset = factorial(cascade - 1);
-  for (int i = 0; i < cascade; i++) {
+  for (int i = 0; i < cascade && filtIdx < MAX_FILTERS; i++) {
     Qval = (cascade == 1) ? Qval : Qvals[iOffset+i];
     filter[filtIdx++] = new Biquad(ftype, cutoff, Qval, gain);
   }
 }
 
-void setupFilters() {
+void FilterChain::setup(uint32_t sampleRate) {
+  // configure chain from current web filter parameters
+  rate = sampleRate;
   calcQvals();
-  filtIdx = 0;
+  clearBiquads();
   long framesize = sampleBytes / sizeof(int16_t);
   if (RING_MOD) generateSineWave(SW_FREQ, SW_AMP);
   if (BAND_PASS) initBiquad(bq_type_bandpass, BP_FREQ, BP_Q, 0, BP_CAS);
@@ -110,52 +249,116 @@ void setupFilters() {
   if (HIGH_SHELF) initBiquad(bq_type_highshelf, HS_FREQ, 1, HS_GAIN, 1);
   if (LOW_SHELF) initBiquad(bq_type_lowshelf, LS_FREQ, 1, LS_GAIN, 1);
   if (PEAK) initBiquad(bq_type_peak, PK_FREQ, PK_Q, PK_GAIN, 1);
-  if (PITCH_SHIFT != 1.0) smbPitchShiftInit(PITCH_SHIFT, framesize, OSAMP, SAMPLE_RATE);
+  vocoderOn = VOCODER && vocoder.init(VOC_BANDS, VOC_CARRIER, VOC_FREQ, rate);
+  if (live) vocoderBands = vocoderOn ? vocoder.getBands() : 0;
+  delayOn = DELAY_LINE && delayEffect.init(DELAY_TYPE, DELAY_MIX / 10.0, rate);
+  reverbType = RV_TYPE;
+  // FDN decay time 4s to 0.4s, room size 0.56 to 2.0
+  if (REVERB) reverbOn = reverbType ? fdnReverb.init(0.4 + RV_SIZE * 0.16, 4.0 / std::max(DECAY_FACTOR, 1), RV_DAMP / 12.0, rate) : initComb();
+  else reverbOn = false;
+  stftOn = PITCH_SHIFT != 1.0 || NOISE_SUPP;
+  if (stftOn) {
+    // pitch shift and noise suppression share same STFT,
+    // noise state setup after STFT init as that releases it
+    smbPitchShiftInit(&stft, PITCH_SHIFT, framesize, OSAMP, rate);
+    stft.shareSpectrum = live;
+    if (NOISE_SUPP) noiseSuppressInit(&stft.ns, framesize, framesize / OSAMP, rate, NS_LEVEL);
+  }
+  outGain = live ? getVolumeGain() : 1.0;
+  ditherSeed = 22222;
+#ifdef OUT_ESP_DSP
+  // 16 byte aligned for S3 vector instructions, scalar output stage used if unavailable
+  if (vecBuff == NULL) vecBuff = (float*)heap_caps_aligned_alloc(16, 2 * DMA_BUFF_LEN * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#endif
 }
 
-void applyFilters() { 
+void FilterChain::process(int16_t* samples, size_t numSamples) { 
+  uint32_t blockStart = live ? profStart() : 0;
+  uint32_t stageStart = 0;
   if (!DISABLE) {
     // modify input signal using required filters
+    if (live) stageStart = profStart();
     for (int k = 0; k < filtIdx; k++) {
       // apply each required biquad filter in turn
-      for (int i = 0; i < DMA_BUFF_LEN; i++)  
-        sampleBuffer[i] = (int16_t)filter[k]->process((float)sampleBuffer[i]); 
+      for (size_t i = 0; i < numSamples; i++)  
+        samples[i] = (int16_t)filter[k]->process((float)samples[i]); 
     }
+    if (live && filtIdx) profEnd(prof_biquad, stageStart);
   
-    if (RING_MOD) {
+    if (RING_MOD && sineWaveTable != NULL) {
       // output dalek style voice, by multiplying input value with sine wave value
-      for (int i = 0; i < DMA_BUFF_LEN; i++) { 
-        int32_t thisSample = (int32_t)sampleBuffer[i] * sineWaveTable[i % dataPoints];
-        sampleBuffer[i] = (int16_t)(thisSample / SW_AMP); 
+      if (live) stageStart = profStart();
+      for (size_t i = 0; i < numSamples; i++) { 
+        int32_t thisSample = (int32_t)samples[i] * sineWaveTable[sinePtr];
+        samples[i] = (int16_t)(thisSample / SW_AMP); 
+        if (++sinePtr >= dataPoints) sinePtr = 0;
       }
+      if (live) profEnd(prof_ringmod, stageStart);
     }
     
-    // add reverb
-    if (REVERB) {
-      static int16_t reverbBuff[REVERB_SAMPLES] = {0};
-      static size_t reverbPtr = 0;
-      for (int i = 0; i < DMA_BUFF_LEN; i++) {
-        int16_t reverbed = sampleBuffer[i] + reverbBuff[reverbPtr] / (DECAY_FACTOR + 1);
-        sampleBuffer[i] = reverbBuff[reverbPtr] = reverbed;
-        reverbPtr = (reverbPtr + 1) % REVERB_SAMPLES;
+    // replace voice with carrier shaped by voice spectrum
+    if (vocoderOn && VOCODER) {
+      if (live) stageStart = profStart();
+      uint32_t startTime = micros();
+      vocoder.process(samples, numSamples);
+      if (live) {
+        vocoderTime = (vocoderTime * 7 + (micros() - startTime)) / 8;
+        profEnd(prof_vocoder, stageStart);
       }
     }
-  }
-  applyVolume();
 
-  // change pitch if required, resource intensive
-  if (PITCH_SHIFT != 1.0) smbPitchShift(DMA_BUFF_LEN / sizeof(int16_t), sampleBuffer, sampleBuffer);
+    // add chorus, flanger or echo
+    if (delayOn && DELAY_LINE) {
+      if (live) stageStart = profStart();
+      delayEffect.process(samples, numSamples);
+      if (live) profEnd(prof_delay, stageStart);
+    }
 
-  if (!DISABLE) {
-    // clip higher amplitudes 
-    if (CLIPPING) {
-      // clip factor: 1 = soft clip, 10 = hard clip
-      float clipFactor = 1 + CLIP_FACTOR / 6.0;
-      for (int i = 0; i < DMA_BUFF_LEN; i++) {
-        float inputF = (float)(sampleBuffer[i]) / SHRT_MAX;
-        float c = inputF * clipFactor;
-        sampleBuffer[i] = (int16_t)(SHRT_MAX * (1 / clipFactor * (c / (1.0 + 0.28 * (c * c)))));
+    // add reverb
+    if (reverbOn && REVERB) {
+      if (live) stageStart = profStart();
+      uint32_t startTime = micros();
+      if (reverbType) fdnReverb.process(samples, numSamples);
+      else if (combLen) {
+        for (size_t i = 0; i < numSamples; i++) {
+          int16_t reverbed = samples[i] + combBuff[combPtr] / (DECAY_FACTOR + 1);
+          samples[i] = combBuff[combPtr] = reverbed;
+          combPtr = (combPtr + 1) % combLen;
+        }
+      }
+      if (live) {
+        reverbTime = (reverbTime * 7 + (micros() - startTime)) / 8;
+        profEnd(prof_reverb, stageStart);
       }
     }
   }
+  // change pitch and / or suppress noise if required, resource intensive
+  bool denoise = NOISE_SUPP && !DISABLE;
+  if (stftOn && (PITCH_SHIFT != 1.0 || denoise)) {
+    if (live) stageStart = profStart();
+    smbPitchShift(&stft, numSamples, samples, samples, denoise);
+    if (live) profEnd(prof_stft, stageStart);
+  }
+
+  // volume, clip higher amplitudes, dither
+  if (live) stageStart = profStart();
+  outputStage(samples, numSamples);
+  if (live) {
+    profEnd(prof_output, stageStart);
+    profEnd(prof_block, blockStart);
+  }
+}
+
+void setupFilters() {
+  // setup chain applied to live audio
+  liveChain.setup(SAMPLE_RATE);
+  if (VOCODER) vocoderTime = 0;
+  if (REVERB) reverbTime = 0;
+  spectrumInit(sampleBytes / sizeof(int16_t), SAMPLE_RATE);
+  if (DSP_PROFILE) profReset();
+  startProfWs();
+}
+
+void applyFilters(size_t numSamples) {
+  liveChain.process(sampleBuffer, numSamples);
 }
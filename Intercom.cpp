@@ -0,0 +1,267 @@
+//
+// UDP intercom
+//
+// Low latency remote mic and speaker for native clients, as an alternative to the
+// browser mic and speaker over websocket, which suffer from TCP head of line blocking
+// and retransmission delays.
+// Each datagram holds one frame as defined in AudioCodec.h, eg 20ms of PCM or ADPCM.
+// A client sends its mic frames to UDP_PORT, and while it keeps sending, its frames
+// replace the esp mic input, and the processed output is returned to it as frames
+// of the same size and codec.
+// Received frames are held in a jitter buffer indexed by sequence number, and playout
+// starts once UDP_JB_TARGET frames are buffered. A missing frame is concealed by
+// repeating the previous frame at decreasing level. If the buffer grows past
+// UDP_JB_MAX frames due to clock drift or a burst, the oldest frame is discarded.
+// The jitter buffer may be in PSRAM, so samples are copied outside the spinlock,
+// which only guards the slot state and counters. A slot being filled or read is
+// not available to the other task until its state is handed back.
+// See extras/udpIntercom.cpp for a Linux reference client.
+//
+// s60sc 2026
+
+#include "appGlobals.h"
+#include "AudioCodec.h"
+
+#define UDP_JB_SLOTS 16 // jitter buffer frames, power of 2
+#define UDP_JB_TARGET 3 // frames buffered before playout starts
+#define UDP_JB_MAX 8 // frames buffered before oldest discarded
+#define UDP_MAX_SAMPLES 640 // max samples per frame, 40ms at 16kHz
+#define UDP_PLC_MAX 5 // consecutive frames concealed before rebuffering
+#define UDP_TIMEOUT_MS 1000 // client inactive if no frames received
+
+int UDP_PORT = 0; // port for UDP intercom, 0 for none
+
+enum { jb_free = 0, jb_filling, jb_ready, jb_reading };
+
+struct jbSlot {
+  uint16_t seq;
+  uint16_t numSamples;
+  uint8_t state;
+  int16_t samples[UDP_MAX_SAMPLES];
+};
+
+static jbSlot* jbSlots = NULL;
+static uint16_t playSeq; // next frame to play out
+static bool playing = false; // playout started
+static int plcCount = 0; // consecutive frames concealed
+static int16_t lastFrame[UDP_MAX_SAMPLES]; // last frame played, for concealment
+static uint16_t lastLen = 0;
+static uint32_t nextPlayUs; // playout time of next frame
+static int udpSock = -1;
+static struct sockaddr_in udpPeer;
+static uint32_t lastRxTime = 0;
+static uint8_t udpCodec = codec_pcm; // codec and frame size of client, used for reply
+static uint16_t udpFrameLen = 0;
+static codecState udpTx;
+static uint8_t udpTxBuff[CODEC_HDR_LEN + UDP_MAX_SAMPLES * sizeof(int16_t)];
+static portMUX_TYPE udpMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t udpHandle = NULL;
+
+// counters since client started
+static uint32_t udpRx = 0; // frames received
+static uint32_t udpLate = 0; // frames arriving after playout time or duplicated
+static uint32_t udpConcealed = 0; // missing frames concealed
+static uint32_t udpOverflow = 0; // frames discarded as buffer too full
+static uint32_t udpUnderrun = 0; // playout restarted as buffer empty
+
+bool udpActive() {
+  // whether client is currently sending
+  return udpSock >= 0 && udpFrameLen && millis() - lastRxTime < UDP_TIMEOUT_MS;
+}
+
+static void udpReset() {
+  // new client or client restarted
+  // a slot being read is freed by the audio task when done
+  for (int i = 0; i < UDP_JB_SLOTS; i++) if (jbSlots[i].state != jb_reading) jbSlots[i].state = jb_free;
+  playing = false;
+  plcCount = 0;
+  lastLen = 0;
+  udpRx = udpLate = udpConcealed = udpOverflow = udpUnderrun = 0;
+  memset(&udpTx, 0, sizeof(udpTx));
+}
+
+static void jbStore(uint16_t seq, int16_t* samples, size_t numSamples) {
+  // add decoded frame to jitter buffer
+  jbSlot* slot = &jbSlots[seq & (UDP_JB_SLOTS - 1)];
+  bool claimed = false;
+  portENTER_CRITICAL(&udpMux);
+  if (playing && (int16_t)(seq - playSeq) < 0) udpLate++; // already played out
+  else if (playing && (int16_t)(seq - playSeq) >= UDP_JB_SLOTS) udpOverflow++; // too far ahead
+  else if (slot->state == jb_ready && slot->seq == seq) udpLate++; // duplicate
+  else if (slot->state == jb_reading) udpOverflow++; // previous frame in slot still being played out
+  else {
+    slot->state = jb_filling;
+    slot->seq = seq;
+    claimed = true;
+  }
+  portEXIT_CRITICAL(&udpMux);
+  if (!claimed) return;
+
+  // copy samples outside lock, then hand slot to audio task
+  memcpy(slot->samples, samples, numSamples * sizeof(int16_t));
+  portENTER_CRITICAL(&udpMux);
+  slot->numSamples = numSamples;
+  if (playing && (int16_t)(seq - playSeq) < 0) {
+    // playout moved past frame while it was copied
+    slot->state = jb_free;
+    udpLate++;
+  } else {
+    slot->state = jb_ready;
+    udpRx++;
+  }
+  portEXIT_CRITICAL(&udpMux);
+}
+
+static int jbDepth(uint16_t* firstSeq) {
+  // number of frames buffered from playSeq, or from earliest frame if not playing
+  int depth = 0;
+  for (int i = 0; i < UDP_JB_SLOTS; i++) {
+    if (jbSlots[i].state != jb_ready) continue;
+    if (!depth || (int16_t)(jbSlots[i].seq - *firstSeq) < 0) *firstSeq = jbSlots[i].seq;
+    depth++;
+  }
+  return depth;
+}
+
+size_t udpMicInput(int16_t* dest) {
+  // called from audio task to get next frame from jitter buffer at playout rate,
+  // returns number of samples
+  uint16_t firstSeq = 0;
+  if (!playing) {
+    portENTER_CRITICAL(&udpMux);
+    bool ready = jbDepth(&firstSeq) >= UDP_JB_TARGET;
+    if (ready) {
+      playSeq = firstSeq;
+      playing = true;
+    }
+    portEXIT_CRITICAL(&udpMux);
+    if (!ready) {
+      delay(5);
+      return 0;
+    }
+    nextPlayUs = micros();
+  }
+  int32_t waitUs = nextPlayUs - micros();
+  if (waitUs > 1000) delay(waitUs / 1000);
+
+  size_t numSamples = 0;
+  portENTER_CRITICAL(&udpMux);
+  if (jbDepth(&firstSeq) > UDP_JB_MAX) {
+    // discard oldest to reduce latency
+    jbSlot* oldest = &jbSlots[playSeq & (UDP_JB_SLOTS - 1)];
+    if (oldest->state == jb_ready) oldest->state = jb_free;
+    playSeq++;
+    udpOverflow++;
+  }
+  jbSlot* slot = &jbSlots[playSeq & (UDP_JB_SLOTS - 1)];
+  if (slot->state == jb_ready && slot->seq == playSeq) {
+    numSamples = slot->numSamples;
+    slot->state = jb_reading;
+  }
+  playSeq++;
+  portEXIT_CRITICAL(&udpMux);
+
+  if (numSamples) {
+    // copy samples outside lock, then release slot
+    memcpy(dest, slot->samples, numSamples * sizeof(int16_t));
+    portENTER_CRITICAL(&udpMux);
+    slot->state = jb_free;
+    portEXIT_CRITICAL(&udpMux);
+    plcCount = 0;
+    memcpy(lastFrame, dest, numSamples * sizeof(int16_t));
+    lastLen = numSamples;
+  } else if (lastLen && plcCount < UDP_PLC_MAX) {
+    // conceal lost frame by repeating previous frame at half the level each time
+    plcCount++;
+    udpConcealed++;
+    numSamples = lastLen;
+    for (size_t i = 0; i < numSamples; i++) dest[i] = lastFrame[i] >> plcCount;
+  } else {
+    // nothing to play, wait for buffer to refill
+    playing = false;
+    udpUnderrun++;
+    return 0;
+  }
+  nextPlayUs += (uint64_t)numSamples * 1000000 / SAMPLE_RATE;
+  return numSamples;
+}
+
+void udpWrite(int16_t* samples, size_t numSamples) {
+  // called from audio task to return processed output to client, never waits
+  if (!udpActive()) return;
+  struct sockaddr_in peer;
+  portENTER_CRITICAL(&udpMux);
+  memcpy(&peer, &udpPeer, sizeof(peer));
+  portEXIT_CRITICAL(&udpMux);
+  for (size_t i = 0; i < numSamples; i += udpFrameLen) {
+    size_t frameLen = codecEncode(&udpTx, udpCodec, samples + i, std::min((size_t)udpFrameLen, numSamples - i), udpTxBuff);
+    sendto(udpSock, udpTxBuff, frameLen, MSG_DONTWAIT, (struct sockaddr*)&peer, sizeof(peer));
+  }
+}
+
+size_t udpStats(char* p) {
+  // UDP intercom counters as json for web page
+  if (!UDP_PORT) return 0;
+  return sprintf(p, "\"UDPstats\":\"%s, received %lu, late %lu, concealed %lu, overflow %lu, underrun %lu\",", 
+    udpActive() ? "active" : "idle", udpRx, udpLate, udpConcealed, udpOverflow, udpUnderrun);
+}
+
+static void udpTask(void* arg) {
+  // receive client frames into jitter buffer
+  static uint8_t rxBuff[CODEC_HDR_LEN + UDP_MAX_SAMPLES * sizeof(int16_t) + 1];
+  static int16_t rxSamples[UDP_MAX_SAMPLES];
+  codecState rxState = {};
+  struct timeval timeout = {1, 0};
+  setsockopt(udpSock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  while (true) {
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    int len = recvfrom(udpSock, rxBuff, sizeof(rxBuff), 0, (struct sockaddr*)&from, &fromLen);
+    if (len < CODEC_HDR_LEN || rxBuff[0] != CODEC_TAG) continue; // timeout or not a frame
+    uint16_t seq, numSamples;
+    memcpy(&seq, rxBuff + 2, 2);
+    memcpy(&numSamples, rxBuff + 8, 2);
+    if (rxBuff[1] >= CODEC_COUNT || !numSamples || numSamples > UDP_MAX_SAMPLES) continue;
+    bool newClient = !udpActive() || from.sin_addr.s_addr != udpPeer.sin_addr.s_addr || from.sin_port != udpPeer.sin_port;
+    if (newClient) {
+      if (udpActive()) continue; // another client already active
+      portENTER_CRITICAL(&udpMux);
+      memcpy(&udpPeer, &from, sizeof(udpPeer));
+      udpReset();
+      portEXIT_CRITICAL(&udpMux);
+      char addr[INET_ADDRSTRLEN];
+      inet_ntop(AF_INET, &from.sin_addr, addr, sizeof(addr));
+      LOG_INF("UDP intercom client %s:%u using codec %u, %u samples per frame", addr, ntohs(from.sin_port), rxBuff[1], numSamples);
+    }
+    size_t decoded = codecDecode(&rxState, rxBuff, len, rxSamples, UDP_MAX_SAMPLES);
+    if (decoded) {
+      udpCodec = rxBuff[1];
+      udpFrameLen = numSamples;
+      lastRxTime = millis();
+      jbStore(seq, rxSamples, decoded);
+    }
+  }
+}
+
+void prepIntercom() {
+  // open UDP socket and start receive task if port configured
+  if (!UDP_PORT || udpHandle != NULL) return;
+  if (jbSlots == NULL) jbSlots = (jbSlot*)(psramFound() ? ps_calloc(UDP_JB_SLOTS, sizeof(jbSlot)) : calloc(UDP_JB_SLOTS, sizeof(jbSlot)));
+  if (jbSlots == NULL) {
+    LOG_WRN("Insufficient memory for UDP intercom");
+    return;
+  }
+  struct sockaddr_in local = {};
+  local.sin_family = AF_INET;
+  local.sin_port = htons(UDP_PORT);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  udpSock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (udpSock < 0 || bind(udpSock, (struct sockaddr*)&local, sizeof(local)) < 0) {
+    LOG_WRN("Unable to open UDP intercom port %d, error %d", UDP_PORT, errno);
+    if (udpSock >= 0) close(udpSock);
+    udpSock = -1;
+    return;
+  }
+  xTaskCreate(udpTask, "udpTask", UDP_STACK_SIZE, NULL, UDP_PRI, &udpHandle);
+  LOG_INF("UDP intercom listening on port %d", UDP_PORT);
+}
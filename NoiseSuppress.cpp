@@ -0,0 +1,98 @@
+//
+// Spectral noise suppression
+//
+// Applied to each STFT frame of smbPitchShift(), so when pitch shift is also
+// enabled, both share the same FFT / inverse FFT.
+//
+// Noise power per bin is estimated using minimum statistics: the minimum of the
+// smoothed signal power over a sliding window of about 1.5 secs, tracked as a set
+// of sub window minima, is assumed to be noise as speech has gaps.
+// Each bin is then attenuated by a Wiener gain derived from the a priori SNR,
+// estimated using the decision directed method to reduce musical noise.
+// The gain is limited to a floor set by the suppression level.
+//
+// State is held per instance in nsState, see smbPitchShift.h
+//
+// s60sc 2026
+
+#include "smbPitchShift.h"
+
+#define NS_SUBWIN 8 // number of sub windows used for minimum tracking
+#define NS_WIN_SECS 1.5 // duration of minimum tracking window
+#define NS_SMOOTH_SECS 0.05 // time constant for power smoothing
+#define NS_BIAS 1.5 // compensate for minimum being lower than mean noise power
+#define NS_DD 0.98 // decision directed weighting of previous frame
+
+void noiseSuppressFree(nsState* ns) {
+  free(ns->smoothPow);
+  free(ns->currMin);
+  free(ns->subMin);
+  free(ns->noisePow);
+  free(ns->prevClean);
+  ns->smoothPow = ns->currMin = ns->subMin = ns->noisePow = ns->prevClean = NULL;
+  ns->nsBins = 0;
+}
+
+void noiseSuppressInit(nsState* ns, long fftFrameSize, long stepSize, float sampleRate, int level) {
+  // allocate per bin state, level 1 - 10 sets max attenuation of 3 - 30 dB
+  noiseSuppressFree(ns);
+  ns->nsBins = fftFrameSize / 2 + 1;
+  float frameSecs = stepSize / sampleRate;
+  ns->alpha = exp(-frameSecs / NS_SMOOTH_SECS);
+  ns->subLen = std::max(1, (int)(NS_WIN_SECS / frameSecs / NS_SUBWIN));
+  ns->gainFloor = pow(10.0, -3.0 * constrain(level, 1, 10) / 20.0);
+  ns->smoothPow = (float*)calloc(ns->nsBins, sizeof(float));
+  ns->currMin = (float*)calloc(ns->nsBins, sizeof(float));
+  ns->subMin = (float*)calloc(ns->nsBins * NS_SUBWIN, sizeof(float));
+  ns->noisePow = (float*)calloc(ns->nsBins, sizeof(float));
+  ns->prevClean = (float*)calloc(ns->nsBins, sizeof(float));
+  if (ns->smoothPow == NULL || ns->currMin == NULL || ns->subMin == NULL || ns->noisePow == NULL || ns->prevClean == NULL) {
+    LOG_WRN("Insufficient memory for noise suppression");
+    ns->nsBins = 0;
+    return;
+  }
+  ns->subIdx = ns->frameCnt = 0;
+  ns->firstFrame = true;
+  LOG_INF("Noise suppression over %ld bins, floor %0.0fdB, noise window %0.1fs",
+    ns->nsBins, 20 * log10(ns->gainFloor), ns->subLen * NS_SUBWIN * frameSecs);
+}
+
+void noiseSuppress(nsState* ns, float* fftBuffer, long fftFrameSize2) {
+  // attenuate noise in interleaved complex spectrum bins 0 .. fftFrameSize2 in place
+  if (!ns->nsBins || fftFrameSize2 >= ns->nsBins) return;
+  for (long k = 0; k <= fftFrameSize2; k++) {
+    float real = fftBuffer[2*k];
+    float imag = fftBuffer[2*k+1];
+    float power = real*real + imag*imag;
+    if (ns->firstFrame) {
+      // seed estimates from first frame
+      ns->smoothPow[k] = ns->currMin[k] = ns->noisePow[k] = power;
+      for (int s = 0; s < NS_SUBWIN; s++) ns->subMin[s*ns->nsBins + k] = power;
+    }
+    ns->smoothPow[k] = ns->alpha * ns->smoothPow[k] + (1 - ns->alpha) * power;
+    if (ns->smoothPow[k] < ns->currMin[k]) ns->currMin[k] = ns->smoothPow[k];
+    float noise = NS_BIAS * std::min(ns->noisePow[k], ns->currMin[k]) + 1e-12;
+
+    // wiener gain from decision directed a priori SNR
+    float snrPost = power / noise;
+    float snrPrio = NS_DD * ns->prevClean[k] / noise + (1 - NS_DD) * std::max(snrPost - 1, 0.0f);
+    float gain = std::max(snrPrio / (1 + snrPrio), ns->gainFloor);
+    ns->prevClean[k] = gain * gain * power;
+    fftBuffer[2*k] = real * gain;
+    fftBuffer[2*k+1] = imag * gain;
+  }
+  ns->firstFrame = false;
+
+  if (++ns->frameCnt >= ns->subLen) {
+    // sub window complete, replace oldest sub window minimum and update noise estimate
+    ns->frameCnt = 0;
+    memcpy(ns->subMin + ns->subIdx * ns->nsBins, ns->currMin, ns->nsBins * sizeof(float));
+    ns->subIdx = (ns->subIdx + 1) % NS_SUBWIN;
+    for (long k = 0; k < ns->nsBins; k++) {
+      float minVal = ns->subMin[k];
+      for (int s = 1; s < NS_SUBWIN; s++) minVal = std::min(minVal, ns->subMin[s*ns->nsBins + k]);
+      ns->noisePow[k] = minVal;
+      ns->currMin[k] = ns->smoothPow[k];
+    }
+  }
+}
@@ -0,0 +1,250 @@
+//
+// Offline render of recording through the filter chain
+//
+// The recording in PSRAM is processed by a separate FilterChain instance in a
+// render task, so live audio is not disturbed. Rendering is pipelined with
+// sending to the browser via a pair of buffers each of several DMA blocks:
+// the render task fills one buffer while the web server task sends the other.
+// The render task runs at lower priority than audio and web tasks, so runs as
+// fast as the remaining CPU allows, usually much faster than real time.
+//
+// Uploaded WAV files are also processed by their own FilterChain instance, see
+// processHandler(). Each received chunk is converted, filtered and sent back in
+// the same response, so file size is not limited by memory.
+//
+// s60sc 2026
+
+#include <atomic>
+#include "FilterChain.h"
+#include "WavConvert.h"
+
+#define PROCESS_CHUNK 2048 // bytes of upload received at a time
+
+struct renderJob {
+  const int16_t* src; // samples to render
+  size_t numSamples;
+  int16_t* buff[RENDER_BUFFS];
+  size_t buffLen[RENDER_BUFFS]; // samples rendered into each buffer
+  QueueHandle_t freeQueue; // index of buffers available to render task
+  QueueHandle_t fullQueue; // index of rendered buffers, -1 when finished
+  volatile bool abort;
+  uint32_t renderTime; // total us spent rendering
+  std::atomic<int> users; // render task and sender, job freed by last to finish with it
+};
+
+static void renderFree(renderJob* job);
+
+static void renderRelease(renderJob* job) {
+  // job on heap as sender may give up waiting while render task still running
+  if (--job->users == 0) {
+    renderFree(job);
+    delete job;
+  }
+}
+
+static void renderTask(void* arg) {
+  // render source into each free buffer in turn
+  renderJob* job = (renderJob*)arg;
+  FilterChain* chain = new FilterChain();
+  chain->setup(SAMPLE_RATE);
+  size_t srcPos = 0;
+  int idx;
+  while (srcPos < job->numSamples && !job->abort) {
+    if (xQueueReceive(job->freeQueue, &idx, portMAX_DELAY) != pdTRUE || job->abort) break;
+    uint32_t startTime = micros();
+    size_t len = std::min((size_t)(RENDER_BLOCKS * DMA_BUFF_LEN), job->numSamples - srcPos);
+    memcpy(job->buff[idx], job->src + srcPos, len * sizeof(int16_t));
+    for (size_t i = 0; i < len; i += DMA_BUFF_LEN) 
+      chain->process(job->buff[idx] + i, std::min((size_t)DMA_BUFF_LEN, len - i));
+    job->renderTime += micros() - startTime;
+    job->buffLen[idx] = len;
+    srcPos += len;
+    xQueueSend(job->fullQueue, &idx, portMAX_DELAY);
+  }
+  delete chain;
+  idx = -1; // signal finished
+  xQueueSend(job->fullQueue, &idx, portMAX_DELAY);
+  renderRelease(job);
+  vTaskDelete(NULL);
+}
+
+static bool renderAlloc(renderJob* job) {
+  // buffers and queues for render job
+  for (int i = 0; i < RENDER_BUFFS; i++) {
+    job->buff[i] = (int16_t*)ps_malloc(RENDER_BLOCKS * DMA_BUFF_LEN * sizeof(int16_t));
+    if (job->buff[i] == NULL) return false;
+  }
+  job->freeQueue = xQueueCreate(RENDER_BUFFS, sizeof(int));
+  job->fullQueue = xQueueCreate(RENDER_BUFFS + 1, sizeof(int));
+  if (job->freeQueue == NULL || job->fullQueue == NULL) return false;
+  for (int i = 0; i < RENDER_BUFFS; i++) xQueueSend(job->freeQueue, &i, 0);
+  return true;
+}
+
+static void renderFree(renderJob* job) {
+  for (int i = 0; i < RENDER_BUFFS; i++) free(job->buff[i]);
+  if (job->freeQueue != NULL) vQueueDelete(job->freeQueue);
+  if (job->fullQueue != NULL) vQueueDelete(job->fullQueue);
+}
+
+esp_err_t renderSend(httpd_req_t* req, const int16_t* src, size_t numSamples) {
+  // render samples through current filter settings and send as chunks,
+  // caller has already sent any header
+  renderJob* job = new renderJob();
+  job->src = src;
+  job->numSamples = numSamples;
+  job->users = 2;
+  if (!renderAlloc(job)) {
+    LOG_WRN("Insufficient memory for render");
+    renderFree(job);
+    delete job;
+    return ESP_FAIL;
+  }
+  uint32_t startTime = millis();
+  if (xTaskCreate(renderTask, "renderTask", RENDER_STACK_SIZE, job, RENDER_PRI, NULL) != pdPASS) {
+    LOG_WRN("Failed to start render task");
+    renderFree(job);
+    delete job;
+    return ESP_FAIL;
+  }
+  esp_err_t res = ESP_OK;
+  size_t sentSamples = 0;
+  int idx;
+  while (true) {
+    // send each rendered buffer and return it to render task, until render task finished
+    if (xQueueReceive(job->fullQueue, &idx, pdMS_TO_TICKS(RENDER_TIMEOUT * 1000)) != pdTRUE) {
+      // render task stalled, tell it to stop and leave it to release job
+      LOG_ERR("Render timed out");
+      job->abort = true;
+      idx = 0;
+      xQueueSend(job->freeQueue, &idx, 0); // wake render task if waiting for buffer
+      renderRelease(job);
+      return ESP_FAIL;
+    }
+    if (idx < 0) break;
+    if (res == ESP_OK) {
+      res = httpd_resp_send_chunk(req, (char*)job->buff[idx], job->buffLen[idx] * sizeof(int16_t));
+      if (res == ESP_OK) sentSamples += job->buffLen[idx];
+      else job->abort = true; // browser gone, stop rendering
+    }
+    xQueueSend(job->freeQueue, &idx, 0);
+  }
+  uint32_t elapsed = std::max(millis() - startTime, (uint32_t)1);
+  float audioSecs = (float)sentSamples / SAMPLE_RATE;
+  if (res == ESP_OK) LOG_INF("Rendered %u samples in %lums: %0.0f samples/s, %0.1fx real time (render only %0.1fx)", 
+    sentSamples, elapsed, sentSamples * 1000.0 / elapsed, audioSecs * 1000 / elapsed, 
+    audioSecs * 1000000 / std::max(job->renderTime, (uint32_t)1));
+  else LOG_WRN("Render aborted after %u of %u samples", sentSamples, numSamples);
+  renderRelease(job);
+  return res;
+}
+
+/************************ uploaded file processing *************************/
+
+static bool processBusy = false;
+
+static esp_err_t processError(httpd_req_t* req, const char* status, const char* msg) {
+  // response before any audio sent
+  LOG_WRN("Process upload failed: %s", msg);
+  httpd_resp_set_status(req, status);
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_sendstr(req, msg);
+}
+
+static void processTask(void* arg) {
+  // receive, convert, filter and return uploaded WAV a chunk at a time
+  httpd_req_t* req = (httpd_req_t*)arg;
+  uint8_t* inBuff = (uint8_t*)malloc(PROCESS_CHUNK);
+  int16_t* outBuff = (int16_t*)malloc(sampleBytes);
+  WavConverter* conv = new WavConverter();
+  FilterChain* chain = new FilterChain();
+  conv->begin(SAMPLE_RATE);
+  chain->setup(SAMPLE_RATE);
+  esp_err_t res = inBuff == NULL || outBuff == NULL ? ESP_FAIL : ESP_OK;
+  if (res != ESP_OK) processError(req, "500 Internal Server Error", "Insufficient memory");
+  bool started = false; // response header sent
+  size_t remaining = req->content_len;
+  size_t outSamples = 0;
+  uint32_t renderTime = 0;
+  uint32_t startTime = millis();
+  while (remaining && res == ESP_OK) {
+    int len = httpd_req_recv(req, (char*)inBuff, std::min(remaining, (size_t)PROCESS_CHUNK));
+    if (len == HTTPD_SOCK_ERR_TIMEOUT) continue;
+    if (len <= 0) {
+      LOG_WRN("Process upload receive failed with status %i", len);
+      res = ESP_FAIL;
+      break;
+    }
+    remaining -= len;
+    size_t inPos = 0;
+    while (inPos < (size_t)len && res == ESP_OK && !conv->finished()) {
+      // convert as much of chunk as fits in output block
+      size_t used;
+      size_t numSamples = conv->convert(inBuff + inPos, len - inPos, &used, outBuff, DMA_BUFF_LEN);
+      inPos += used;
+      if (conv->error()) {
+        if (started) res = ESP_FAIL;
+        else res = processError(req, "415 Unsupported Media Type", conv->error()) == ESP_OK ? ESP_ERR_NOT_SUPPORTED : ESP_FAIL;
+        break;
+      }
+      if (!numSamples) continue;
+      if (!started) {
+        // length of output not known until input finished
+        uint8_t hdr[WAV_HDR_LEN];
+        makeWavHeader(hdr, SAMPLE_RATE, 0xFFFFFFFF);
+        httpd_resp_set_type(req, "audio/wav");
+        httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"processed.wav\"");
+        httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+        res = httpd_resp_send_chunk(req, (char*)hdr, WAV_HDR_LEN);
+        started = true;
+      }
+      uint32_t renderStart = micros();
+      chain->process(outBuff, numSamples);
+      renderTime += micros() - renderStart;
+      if (res == ESP_OK) res = httpd_resp_send_chunk(req, (char*)outBuff, numSamples * sizeof(int16_t));
+      outSamples += numSamples;
+    }
+    // any data after end of WAV data chunk is received and ignored
+  }
+  while (remaining && res == ESP_ERR_NOT_SUPPORTED) {
+    // discard rest of unsupported upload so connection can be reused
+    int len = httpd_req_recv(req, (char*)inBuff, std::min(remaining, (size_t)PROCESS_CHUNK));
+    if (len == HTTPD_SOCK_ERR_TIMEOUT) continue;
+    if (len <= 0) break;
+    remaining -= len;
+  }
+  if (res == ESP_OK) {
+    if (!started) processError(req, "415 Unsupported Media Type", "No WAV audio data");
+    else {
+      httpd_resp_send_chunk(req, NULL, 0);
+      uint32_t elapsed = std::max(millis() - startTime, (uint32_t)1);
+      float audioSecs = (float)outSamples / SAMPLE_RATE;
+      LOG_INF("Processed %u uploaded samples in %lums: %0.1fx real time (filters only %0.1fx)", 
+        outSamples, elapsed, audioSecs * 1000 / elapsed, audioSecs * 1000000 / std::max(renderTime, (uint32_t)1));
+    }
+  } else if (res == ESP_FAIL) LOG_WRN("Process upload aborted after %u samples", outSamples);
+  delete chain;
+  delete conv;
+  free(inBuff);
+  free(outBuff);
+  httpd_req_async_handler_complete(req);
+  processBusy = false;
+  vTaskDelete(NULL);
+}
+
+esp_err_t processHandler(httpd_req_t* req) {
+  // POST of WAV file returned with current filtering applied,
+  // processed in own task so web server is not held up
+  if (processBusy) return processError(req, "503 Service Unavailable", "Already processing a file");
+  if (!req->content_len) return processError(req, "400 Bad Request", "No file uploaded");
+  httpd_req_t* asyncReq;
+  if (httpd_req_async_handler_begin(req, &asyncReq) != ESP_OK) return ESP_FAIL;
+  processBusy = true;
+  if (xTaskCreate(processTask, "processTask", RENDER_STACK_SIZE, asyncReq, RENDER_PRI, NULL) != pdPASS) {
+    LOG_WRN("Failed to start process task");
+    processBusy = false;
+    httpd_req_async_handler_complete(asyncReq);
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
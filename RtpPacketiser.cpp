@@ -0,0 +1,65 @@
+//
+// RtpPacketiser.cpp
+//
+// Ring of audio samples read out as fixed size RTP packets, see RtpPacketiser.h
+//
+// s60sc 2026
+
+#include "RtpPacketiser.h"
+#include <string.h>
+
+size_t rtpPacketLen(uint32_t sampleRate, int ptimeMs, size_t maxPayload) {
+  // samples per packet for ptime of 10 to 40 ms, limited to max payload bytes
+  if (ptimeMs < 10) ptimeMs = 10;
+  if (ptimeMs > 40) ptimeMs = 40;
+  size_t packetLen = sampleRate * ptimeMs / 1000;
+  size_t maxLen = maxPayload / sizeof(int16_t);
+  return packetLen > maxLen ? maxLen : packetLen;
+}
+
+RtpPacketiser::RtpPacketiser() : head(0), tail(0) {
+  ring = contig = NULL;
+  mask = packetLen = skipMargin = 0;
+  maxDepth = 0;
+}
+
+bool RtpPacketiser::init(int16_t* ringBuff, size_t ringLen, int16_t* packetBuff, size_t packetSamples, size_t skipSamples) {
+  // ring length must be power of 2 and hold a packet plus skip margin
+  if (ringBuff == NULL || packetBuff == NULL || !packetSamples || (ringLen & (ringLen - 1)) 
+    || packetSamples + skipSamples > ringLen) return false;
+  contig = packetBuff;
+  mask = ringLen - 1;
+  packetLen = packetSamples;
+  skipMargin = skipSamples;
+  head.store(0);
+  tail.store(0);
+  maxDepth = 0;
+  ring = ringBuff;
+  return true;
+}
+
+bool RtpPacketiser::write(const int16_t* samples, size_t numSamples) {
+  // called by writer to queue block, returns false if dropped as ring full
+  if (ring == NULL) return false;
+  uint32_t headPos = head.load();
+  uint32_t newDepth = headPos - tail.load() + numSamples;
+  if (newDepth > mask + 1) return false;
+  if (newDepth > maxDepth) maxDepth = newDepth;
+  size_t writePos = headPos & mask;
+  size_t firstLen = numSamples < mask + 1 - writePos ? numSamples : mask + 1 - writePos;
+  memcpy(ring + writePos, samples, firstLen * sizeof(int16_t));
+  memcpy(ring, samples + firstLen, (numSamples - firstLen) * sizeof(int16_t));
+  head.store(headPos + numSamples);
+  return true;
+}
+
+const int16_t* RtpPacketiser::packet() {
+  // called by reader once ready() to get contiguous packet at tail
+  size_t readPos = tail.load() & mask;
+  if (readPos + packetLen <= mask + 1) return ring + readPos;
+  // packet wraps, so make contiguous
+  size_t firstLen = mask + 1 - readPos;
+  memcpy(contig, ring + readPos, firstLen * sizeof(int16_t));
+  memcpy(contig + firstLen, ring, (packetLen - firstLen) * sizeof(int16_t));
+  return contig;
+}
@@ -0,0 +1,46 @@
+//
+// RtpPacketiser.h
+//
+// Cuts audio blocks queued by the audio task into fixed size RTP packets for the
+// RTSP sender task, see rtsp.cpp.
+// Blocks are written to a power of two ring of samples and read back as packets of
+// packetLen samples regardless of the block size. A packet wrapping the end of the
+// ring is copied into a contiguous packet buffer.
+// One writer task and one reader task, with head and tail as free running sample
+// counts so that depth is their difference.
+// If the ring is full a block is dropped whole. If the reader cannot send, packets
+// are only skipped once skipMargin samples beyond a whole packet are queued, so a
+// briefly busy server does not lose audio while an absent one does not add latency.
+// No Arduino dependencies, so also built on the host by extras/rtpPacketTest.cpp
+//
+// s60sc 2026
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+size_t rtpPacketLen(uint32_t sampleRate, int ptimeMs, size_t maxPayload);
+
+class RtpPacketiser {
+public:
+  RtpPacketiser();
+  bool init(int16_t* ringBuff, size_t ringLen, int16_t* packetBuff, size_t packetSamples, size_t skipSamples);
+  bool write(const int16_t* samples, size_t numSamples);
+  bool ready() { return depth() >= packetLen; }
+  bool backlogged() { return depth() >= packetLen + skipMargin; }
+  const int16_t* packet();
+  void advance() { tail.store(tail.load() + packetLen); }
+  uint32_t depth() { return head.load() - tail.load(); }
+  size_t samples() { return packetLen; }
+  uint32_t maxDepth; // max samples queued
+
+protected:
+  int16_t* ring;
+  int16_t* contig; // copy of packet wrapping end of ring
+  size_t mask;
+  size_t packetLen;
+  size_t skipMargin;
+  std::atomic<uint32_t> head; // samples queued
+  std::atomic<uint32_t> tail; // samples sent or skipped
+};
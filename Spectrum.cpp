@@ -0,0 +1,150 @@
+//
+// Spectrum analyzer
+//
+// Output audio is reduced to log spaced bands plus RMS and peak levels, sent to
+// the browser as a binary websocket frame at up to SPEC_FPS frames per sec, limited
+// by the audio block rate.
+// When pitch shift is active, the magnitudes of its synthesis frames, which hold
+// the shifted spectrum, are reused with the current volume gain applied.
+// Otherwise when a frame is due, the latest output block, after volume and
+// clipping, is windowed and transformed here.
+// The fft buffer is only (re)allocated by the audio task, when next needed.
+//
+// Frame format, with each level a byte scaled from -96 dBFS (0) to 0 dBFS (255):
+//   "SPEC", SPEC_BANDS band levels, RMS level, peak level
+//
+// s60sc 2026
+
+#include "appGlobals.h"
+
+#define SPEC_BANDS 64
+#define SPEC_LO_FREQ 50.0 // lower edge of lowest band in Hz
+#define SPEC_FLOOR_DB -96.0 // level shown as zero
+#define SPEC_HDR_LEN 4
+
+int SPEC_FPS; // spectrum frames per sec sent to browser, 0 for none
+
+static float* specFft = NULL; // interleaved complex fft buffer
+static long specFrameSize = 0; // size of current fft buffer
+static long specSize = 0; // requested frame size, 0 if allocation failed
+static float specRate = 0;
+static bool specReady = false; // setup done for requested frame size and rate
+static float specNorm; // power of full scale sine in one bin
+static float bandPow[SPEC_BANDS]; // max power per band since last frame
+static uint16_t bandLo[SPEC_BANDS]; // first bin for each band
+static uint16_t bandHi[SPEC_BANDS]; // last bin for each band
+static bool haveBins = false; // band powers updated from STFT since last frame
+static uint64_t sumSq = 0;
+static uint32_t levelSamples = 0;
+static int32_t peakVal = 0;
+static uint32_t lastFrame = 0;
+static uint8_t specFrame[SPEC_HDR_LEN + SPEC_BANDS + 2] = {'S', 'P', 'E', 'C'};
+
+static bool specSetup() {
+  // allocate fft buffer and map bins to bands for requested frame size and rate
+  long fftFrameSize = specSize;
+  float sampleRate = specRate;
+  if (fftFrameSize <= 0 || sampleRate <= 0) return false;
+  if (fftFrameSize != specFrameSize) {
+    free(specFft);
+    specFft = (float*)malloc(2 * fftFrameSize * sizeof(float));
+    if (specFft == NULL) {
+      LOG_WRN("Insufficient memory for spectrum analyzer");
+      specFrameSize = specSize = 0; // not retried till next setup
+      return false;
+    }
+    specFrameSize = fftFrameSize;
+  }
+  float ratio = pow(sampleRate / 2 / SPEC_LO_FREQ, 1.0 / SPEC_BANDS);
+  float binHz = sampleRate / fftFrameSize;
+  for (int b = 0; b < SPEC_BANDS; b++) {
+    // low bands narrower than a bin share the nearest bin
+    bandLo[b] = std::max(1, (int)round(SPEC_LO_FREQ * pow(ratio, b) / binHz));
+    bandHi[b] = constrain((int)round(SPEC_LO_FREQ * pow(ratio, b + 1) / binHz) - 1, (int)bandLo[b], (int)fftFrameSize / 2);
+    bandLo[b] = std::min(bandLo[b], bandHi[b]);
+  }
+  // hann windowed full scale sine gives bin magnitude of a quarter frame size
+  specNorm = pow(fftFrameSize / 4.0, 2);
+  memset(bandPow, 0, sizeof(bandPow));
+  haveBins = false;
+  sumSq = levelSamples = peakVal = 0;
+  lastFrame = millis();
+  return true;
+}
+
+void spectrumInit(long fftFrameSize, float sampleRate) {
+  // called from setupFilters() on audio task, setup done now if spectrum wanted
+  specSize = fftFrameSize;
+  specRate = sampleRate;
+  specReady = SPEC_FPS > 0 && specSetup();
+}
+
+static void bandPower(float* fftBuffer) {
+  // max bin power in each band
+  for (int b = 0; b < SPEC_BANDS; b++) {
+    for (int k = bandLo[b]; k <= bandHi[b]; k++) {
+      float power = fftBuffer[2*k] * fftBuffer[2*k] + fftBuffer[2*k+1] * fftBuffer[2*k+1];
+      if (power > bandPow[b]) bandPow[b] = power;
+    }
+  }
+}
+
+void spectrumBins(const float* magn, long fftFrameSize2) {
+  // reuse synthesis magnitudes from smbPitchShift(), called on audio task
+  if (SPEC_FPS <= 0 || !specReady || fftFrameSize2 * 2 != specFrameSize) return;
+  for (int b = 0; b < SPEC_BANDS; b++) {
+    for (int k = bandLo[b]; k <= bandHi[b]; k++) {
+      // synthesis magnitude is twice the bin magnitude
+      float power = magn[k] * magn[k] / 4;
+      if (power > bandPow[b]) bandPow[b] = power;
+    }
+  }
+  haveBins = true;
+}
+
+static inline uint8_t levelByte(float dB) {
+  return (uint8_t)constrain((dB - SPEC_FLOOR_DB) * 255 / -SPEC_FLOOR_DB, 0, 255);
+}
+
+void spectrumUpdate(int16_t* samples, size_t numSamples) {
+  // accumulate levels of output block, and send frame to browser when due
+  if (SPEC_FPS <= 0 || !wsSubscribed(ws_spectrum)) return;
+  if (!specReady && !(specReady = specSetup())) return; // enabled since last setup
+  for (size_t i = 0; i < numSamples; i++) {
+    sumSq += (int32_t)samples[i] * samples[i];
+    peakVal = std::max(peakVal, abs((int32_t)samples[i]));
+  }
+  levelSamples += numSamples;
+  // frames paced from due time rather than send time, so block rate jitter does not lower frame rate
+  uint32_t period = 1000 / SPEC_FPS;
+  uint32_t now = millis();
+  if (now - lastFrame < period) return;
+  lastFrame += period;
+  if (now - lastFrame >= period) lastFrame = now; // too far behind, eg after idle, so restart
+
+  if (haveBins) {
+    // STFT magnitudes precede the output stage, so apply its gain
+    float gain = getVolumeGain();
+    for (int b = 0; b < SPEC_BANDS; b++) bandPow[b] *= gain * gain;
+  } else {
+    // transform latest block, zero padded if shorter than frame
+    size_t len = std::min((size_t)specFrameSize, numSamples);
+    int16_t* startSample = samples + numSamples - len;
+    for (long k = 0; k < specFrameSize; k++) {
+      float window = -.5 * cos(2. * M_PI * (float)k / (float)specFrameSize) + .5;
+      specFft[2*k] = (size_t)k < len ? startSample[k] / 32768.0 * window : 0;
+      specFft[2*k+1] = 0;
+    }
+    smbFft(specFft, specFrameSize, -1);
+    bandPower(specFft);
+  }
+  for (int b = 0; b < SPEC_BANDS; b++) {
+    specFrame[SPEC_HDR_LEN + b] = levelByte(10 * log10(bandPow[b] / specNorm + 1e-12));
+    bandPow[b] = 0;
+  }
+  specFrame[SPEC_HDR_LEN + SPEC_BANDS] = levelByte(10 * log10((double)sumSq / std::max(levelSamples, (uint32_t)1) / (32768.0 * 32768.0) + 1e-12));
+  specFrame[SPEC_HDR_LEN + SPEC_BANDS + 1] = levelByte(20 * log10(peakVal / 32768.0 + 1e-6));
+  sumSq = levelSamples = peakVal = 0;
+  haveBins = false;
+  wsAsyncSendBinary(specFrame, sizeof(specFrame), false, ws_spectrum);
+}
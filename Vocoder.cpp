@@ -0,0 +1,131 @@
+//
+// Vocoder.cpp
+//
+// Channel vocoder, see Vocoder.h
+//
+// Each chunk is processed band by band, so the biquad bank runs over a whole
+// chunk per band rather than over all bands per sample.
+//
+// s60sc 2026
+
+#include "Vocoder.h"
+
+Vocoder::Vocoder() {
+  envelope = modBuff = carBuff = bandBuff = envBuff = outBuff = NULL;
+  numBands = 0;
+  loopData = NULL;
+  noiseSeed = 22222;
+}
+
+Vocoder::~Vocoder() {
+  free(envelope);
+  free(modBuff);
+}
+
+bool Vocoder::init(int bands, int carrier, float carrierFreq, uint32_t sampleRate) {
+  // setup matching analysis and synthesis banks with log spaced bands
+  numBands = 0;
+  bands = constrain(bands, VOC_MIN_BANDS, VOC_MAX_BANDS);
+  if (!analysis.init(bands) || !synthesis.init(bands)) return false;
+  float hiFreq = std::min(VOC_HI_FREQ, sampleRate * 0.45);
+  float ratio = pow(hiFreq / VOC_LO_FREQ, 1.0 / (bands - 1));
+  float Q = sqrt(ratio) / (ratio - 1); // adjacent bands meet at -3dB
+  for (int b = 0; b < bands; b++) {
+    float Fc = VOC_LO_FREQ * pow(ratio, b) / sampleRate;
+    analysis.setBand(b, bq_type_bandpass, Fc, Q, 0);
+    synthesis.setBand(b, bq_type_bandpass, Fc, Q, 0);
+  }
+
+  // chunk buffers share one allocation
+  free(envelope);
+  free(modBuff);
+  envelope = (float*)heap_caps_calloc(bands, sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  modBuff = (float*)heap_caps_malloc(5 * VOC_CHUNK * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (envelope == NULL || modBuff == NULL) {
+    LOG_WRN("Insufficient memory for vocoder");
+    return false;
+  }
+  carBuff = modBuff + VOC_CHUNK;
+  bandBuff = carBuff + VOC_CHUNK;
+  envBuff = bandBuff + VOC_CHUNK;
+  outBuff = envBuff + VOC_CHUNK;
+
+  attack = 1 - exp(-1000.0 / (VOC_ATTACK_MS * sampleRate));
+  release = 1 - exp(-1000.0 / (VOC_RELEASE_MS * sampleRate));
+  phase = 0;
+  noiseSeed = 22222; // same noise sequence each time
+  phaseInc = (uint32_t)(carrierFreq / sampleRate * 4294967296.0);
+  carrierType = carrier;
+  if (carrierType == voc_carrier_recording) {
+    // loop recording held in PSRAM
+    loopLen = recAudioBuffer != NULL && recAudioBytes > WAV_HDR_LEN ? (recAudioBytes - WAV_HDR_LEN) / sizeof(int16_t) : 0;
+    if (loopLen < VOC_CHUNK) {
+      LOG_WRN("No recording available for vocoder carrier, using sawtooth");
+      carrierType = voc_carrier_saw;
+    } else loopData = (int16_t*)(recAudioBuffer + WAV_HDR_LEN);
+    loopPos = 0;
+  }
+  numBands = bands;
+  LOG_INF("Vocoder using %d bands from %0.0fHz to %0.0fHz, Q %0.1f, carrier %d", numBands, VOC_LO_FREQ, hiFreq, Q, carrierType);
+  return true;
+}
+
+void Vocoder::makeCarrier(float* dest, size_t len) {
+  // generate next chunk of carrier, scaled to +/- 1
+  switch (carrierType) {
+    case voc_carrier_noise:
+      for (size_t i = 0; i < len; i++) {
+        // xorshift32 white noise
+        noiseSeed ^= noiseSeed << 13;
+        noiseSeed ^= noiseSeed >> 17;
+        noiseSeed ^= noiseSeed << 5;
+        dest[i] = (int32_t)noiseSeed / 2147483648.0f;
+      }
+    break;
+    case voc_carrier_recording:
+      for (size_t i = 0; i < len; i++) {
+        dest[i] = loopData[loopPos] / 32768.0f;
+        if (++loopPos >= loopLen) loopPos = 0;
+      }
+    break;
+    case voc_carrier_saw:
+    default:
+      for (size_t i = 0; i < len; i++) {
+        dest[i] = (int32_t)phase / 2147483648.0f;
+        phase += phaseInc;
+      }
+    break;
+  }
+}
+
+void Vocoder::processChunk(float* in, size_t len) {
+  // apply modulator band envelopes to carrier bands
+  makeCarrier(carBuff, len);
+  memset(outBuff, 0, len * sizeof(float));
+  for (int b = 0; b < numBands; b++) {
+    // envelope of modulator band
+    analysis.process(b, in, bandBuff, len);
+    float env = envelope[b];
+    for (size_t i = 0; i < len; i++) {
+      float level = fabs(bandBuff[i]);
+      env += (level > env ? attack : release) * (level - env);
+      envBuff[i] = env;
+    }
+    envelope[b] = env;
+    // scale carrier band by envelope
+    synthesis.process(b, carBuff, bandBuff, len);
+    for (size_t i = 0; i < len; i++) outBuff[i] += bandBuff[i] * envBuff[i];
+  }
+  for (size_t i = 0; i < len; i++) in[i] = VOC_GAIN * outBuff[i];
+}
+
+void Vocoder::process(int16_t* samples, size_t numSamples) {
+  // replace block of samples with vocoded output
+  if (!numBands) return;
+  for (size_t i = 0; i < numSamples; i += VOC_CHUNK) {
+    size_t len = std::min((size_t)VOC_CHUNK, numSamples - i);
+    for (size_t j = 0; j < len; j++) modBuff[j] = (float)samples[i + j];
+    processChunk(modBuff, len);
+    for (size_t j = 0; j < len; j++) samples[i + j] = (int16_t)constrain((int32_t)modBuff[j], SHRT_MIN, SHRT_MAX);
+  }
+}
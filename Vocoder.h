@@ -0,0 +1,54 @@
+//
+// Vocoder.h
+//
+// Channel vocoder:
+// - modulator is the mic input, split into log spaced bands by a bandpass biquad bank
+// - envelope of each modulator band is tracked by an attack / release follower
+// - carrier is split by a matching bank, each band scaled by the modulator envelope
+// - carrier is a sawtooth or noise oscillator, or the recording in PSRAM played as a loop
+//
+// s60sc 2026
+
+#pragma once
+#include "appGlobals.h"
+#include "Biquad.h"
+
+#define VOC_MIN_BANDS 16
+#define VOC_MAX_BANDS 32
+#define VOC_LO_FREQ 100.0 // center of lowest band in Hz
+#define VOC_HI_FREQ 5000.0 // center of highest band in Hz, limited by nyquist
+#define VOC_CHUNK 256 // samples processed per pass over bands
+#define VOC_ATTACK_MS 5.0 // envelope follower attack
+#define VOC_RELEASE_MS 30.0 // envelope follower release
+#define VOC_GAIN 2.0 // output makeup gain
+
+enum { voc_carrier_saw = 0, voc_carrier_noise, voc_carrier_recording };
+
+class Vocoder {
+public:
+  Vocoder();
+  ~Vocoder();
+  bool init(int bands, int carrier, float carrierFreq, uint32_t sampleRate);
+  void process(int16_t* samples, size_t numSamples);
+  int getBands() { return numBands; } // bands in use, 0 if not initialised
+
+protected:
+  void makeCarrier(float* dest, size_t len);
+  void processChunk(float* in, size_t len);
+
+  BiquadBank analysis;
+  BiquadBank synthesis;
+  float* envelope;  // current envelope per band
+  float* modBuff;   // modulator chunk
+  float* carBuff;   // carrier chunk
+  float* bandBuff;  // band filter output
+  float* envBuff;   // envelope of current band for chunk
+  float* outBuff;   // summed output
+  int numBands;
+  int carrierType;
+  float attack, release;
+  uint32_t phase, phaseInc; // sawtooth oscillator
+  uint32_t noiseSeed;
+  int16_t* loopData; // recording used as carrier
+  size_t loopLen, loopPos;
+};
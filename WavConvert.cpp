@@ -0,0 +1,193 @@
+//
+// WavConvert.cpp
+//
+// Streaming WAV format and rate conversion, see WavConvert.h
+//
+// s60sc 2026
+
+#include "WavConvert.h"
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+void makeWavHeader(uint8_t* hdr, uint32_t sampleRate, uint32_t dataBytes) {
+  // header for mono 16 bit samples, sizes 0xFFFFFFFF if length unknown
+  uint32_t byteRate = sampleRate * sizeof(int16_t);
+  uint32_t riffBytes = dataBytes == 0xFFFFFFFF ? dataBytes : dataBytes + WAV_HDR_LEN - 8;
+  memcpy(hdr, "RIFF", 4);
+  memcpy(hdr + 4, &riffBytes, 4);
+  memcpy(hdr + 8, "WAVEfmt \x10\0\0\0\x01\0\x01\0", 16);
+  memcpy(hdr + 24, &sampleRate, 4);
+  memcpy(hdr + 28, &byteRate, 4);
+  memcpy(hdr + 32, "\x02\0\x10\0" "data", 8);
+  memcpy(hdr + 40, &dataBytes, 4);
+}
+
+WavConverter::WavConverter() {
+  begin(SAMPLE_RATE);
+}
+
+void WavConverter::begin(uint32_t outputRate) {
+  // prepare for new file
+  state = wav_riff;
+  errMsg = NULL;
+  hdrLen = 12;
+  hdrFill = frameFill = 0;
+  chunkLeft = 0;
+  outRate = outputRate;
+  inRate = channels = bits = 0;
+}
+
+void WavConverter::fail(const char* msg) {
+  errMsg = msg;
+  state = wav_error;
+}
+
+bool WavConverter::parseFmt() {
+  // validate format chunk and setup conversion
+  memcpy(&format, hdrBuff, 2);
+  memcpy(&channels, hdrBuff + 2, 2);
+  memcpy(&inRate, hdrBuff + 4, 4);
+  memcpy(&bits, hdrBuff + 14, 2);
+  if (format == WAV_FORMAT_EXTENSIBLE && hdrFill >= 26) memcpy(&format, hdrBuff + 24, 2); // sub format
+  if (format != WAV_FORMAT_PCM && format != WAV_FORMAT_FLOAT) fail("Unsupported WAV encoding");
+  else if (format == WAV_FORMAT_PCM && bits != 8 && bits != 16 && bits != 24 && bits != 32) fail("Unsupported WAV bit depth");
+  else if (format == WAV_FORMAT_FLOAT && bits != 32) fail("Unsupported WAV float size");
+  else if (!channels || channels > WAV_MAX_CHANNELS) fail("Unsupported WAV channel count");
+  else if (inRate < WAV_MIN_RATE || inRate > WAV_MAX_RATE) fail("Unsupported WAV sample rate");
+  if (state == wav_error) return false;
+  frameBytes = channels * bits / 8;
+  phaseInc = ((uint64_t)inRate << 16) / outRate;
+  phase = 0;
+  prevSample = currSample = 0;
+  filterOn = inRate > outRate;
+  if (filterOn) {
+    // 4th order butterworth lowpass below output nyquist
+    float Fc = 0.45 * outRate / inRate;
+    antiAlias[0].setBiquad(bq_type_lowpass, Fc, 0.5412, 0);
+    antiAlias[1].setBiquad(bq_type_lowpass, Fc, 1.3066, 0);
+  }
+  LOG_INF("WAV input %luHz, %u channels, %u bit %s, output %luHz", inRate, channels, bits, format == WAV_FORMAT_FLOAT ? "float" : "PCM", outRate);
+  return true;
+}
+
+float WavConverter::decodeFrame(const uint8_t* frame) {
+  // average of channels scaled to 16 bit range
+  float sum = 0;
+  for (int c = 0; c < channels; c++) {
+    const uint8_t* s = frame + c * bits / 8;
+    switch (bits) {
+      case 8: sum += (s[0] - 128) * 256.0f; break;
+      case 16: sum += (int16_t)(s[0] | s[1] << 8); break;
+      case 24: sum += (int32_t)((uint32_t)s[0] << 8 | (uint32_t)s[1] << 16 | (uint32_t)s[2] << 24) / 65536.0f; break;
+      case 32: 
+        if (format == WAV_FORMAT_FLOAT) {
+          float f;
+          memcpy(&f, s, 4);
+          sum += f * 32768.0f;
+        } else sum += (int32_t)((uint32_t)s[0] | (uint32_t)s[1] << 8 | (uint32_t)s[2] << 16 | (uint32_t)s[3] << 24) / 65536.0f;
+      break;
+    }
+  }
+  return sum / channels;
+}
+
+size_t WavConverter::resample(float sample, int16_t* out) {
+  // add input sample, output any samples now due, returns count
+  if (filterOn) sample = antiAlias[1].process(antiAlias[0].process(sample));
+  if (inRate == outRate) {
+    *out = constrain((int32_t)sample, SHRT_MIN, SHRT_MAX);
+    return 1;
+  }
+  prevSample = currSample;
+  currSample = sample;
+  size_t outCnt = 0;
+  while (phase < 0x10000) {
+    float interp = prevSample + (currSample - prevSample) * phase / 65536.0f;
+    out[outCnt++] = constrain((int32_t)interp, SHRT_MIN, SHRT_MAX);
+    phase += phaseInc;
+  }
+  phase -= 0x10000;
+  return outCnt;
+}
+
+size_t WavConverter::convert(const uint8_t* in, size_t inLen, size_t* used, int16_t* out, size_t maxOut) {
+  // consume input until output full or input exhausted, returns samples output
+  size_t inPos = 0;
+  size_t outCnt = 0;
+  size_t maxPerFrame = outRate / WAV_MIN_RATE + 2; // output samples from one input frame
+  while (inPos < inLen && state < wav_done) {
+    size_t avail = inLen - inPos;
+    if (state == wav_skip) {
+      // ignore unwanted chunk
+      size_t len = std::min((size_t)chunkLeft, avail);
+      chunkLeft -= len;
+      inPos += len;
+      if (!chunkLeft) {
+        state = wav_chunk;
+        hdrLen = 8;
+      }
+    } else if (state == wav_data) {
+      if (outCnt + maxPerFrame > maxOut) break; // output full
+      const uint8_t* frame;
+      if (!frameFill && avail >= frameBytes) {
+        frame = in + inPos;
+        inPos += frameBytes;
+      } else {
+        // frame split across input chunks
+        size_t len = std::min((size_t)(frameBytes - frameFill), avail);
+        memcpy(frameBuff + frameFill, in + inPos, len);
+        frameFill += len;
+        inPos += len;
+        if (frameFill < frameBytes) break;
+        frameFill = 0;
+        frame = frameBuff;
+      }
+      outCnt += resample(decodeFrame(frame), out + outCnt);
+      if (!dataUnsized && (chunkLeft -= frameBytes) < frameBytes) state = wav_done;
+    } else {
+      // collect fixed size header
+      size_t len = std::min(hdrLen - hdrFill, avail);
+      memcpy(hdrBuff + hdrFill, in + inPos, len);
+      hdrFill += len;
+      inPos += len;
+      if (hdrFill < hdrLen) continue;
+      uint32_t chunkLen;
+      memcpy(&chunkLen, hdrBuff + 4, 4);
+      if (state == wav_riff) {
+        if (memcmp(hdrBuff, "RIFF", 4) || memcmp(hdrBuff + 8, "WAVE", 4)) fail("Not a WAV file");
+        else state = wav_chunk;
+        hdrLen = 8;
+      } else if (state == wav_chunk) {
+        if (!memcmp(hdrBuff, "fmt ", 4)) {
+          if (chunkLen < 16) fail("Invalid WAV format chunk");
+          else {
+            // collect format chunk, skip any excess
+            state = wav_fmt;
+            hdrLen = std::min((size_t)chunkLen, sizeof(hdrBuff));
+            chunkLeft = chunkLen - hdrLen + (chunkLen & 1);
+          }
+        } else if (!memcmp(hdrBuff, "data", 4)) {
+          if (!inRate) fail("WAV data before format");
+          else {
+            state = wav_data;
+            // streamed files may not have length
+            dataUnsized = !chunkLen || chunkLen == 0xFFFFFFFF;
+            chunkLeft = chunkLen;
+            if (!dataUnsized && chunkLeft < frameBytes) state = wav_done;
+          }
+        } else {
+          state = wav_skip;
+          chunkLeft = chunkLen + (chunkLen & 1); // chunks are word aligned
+        }
+      } else if (state == wav_fmt && parseFmt()) {
+        state = chunkLeft ? wav_skip : wav_chunk;
+        hdrLen = 8;
+      }
+      hdrFill = 0;
+    }
+  }
+  *used = inPos;
+  return outCnt;
+}
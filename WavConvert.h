@@ -0,0 +1,64 @@
+//
+// WavConvert.h
+//
+// Streaming conversion of a WAV file of any common format to the mono 16 bit
+// samples at the app sample rate used by the filter chain.
+// The file is fed in chunks of any size, eg as received over http or read from
+// storage, so is never held in memory as a whole:
+// - header chunks are parsed as they arrive, unknown chunks are skipped
+// - 8, 16, 24, 32 bit PCM and 32 bit float, as plain or extensible format
+// - multichannel input is downmixed to mono by averaging
+// - rate is converted by linear interpolation, preceded by a lowpass filter
+//   when downsampling to limit aliasing
+//
+// s60sc 2026
+
+#pragma once
+#include "appGlobals.h"
+#include "Biquad.h"
+
+#define WAV_MAX_CHANNELS 8
+#define WAV_MIN_RATE 8000
+#define WAV_MAX_RATE 96000
+
+void makeWavHeader(uint8_t* hdr, uint32_t sampleRate, uint32_t dataBytes);
+
+class WavConverter {
+public:
+  WavConverter();
+  void begin(uint32_t outputRate);
+  size_t convert(const uint8_t* in, size_t inLen, size_t* used, int16_t* out, size_t maxOut);
+  bool finished() { return state == wav_done; }
+  const char* error() { return errMsg; }
+  uint32_t inputRate() { return inRate; }
+  uint16_t inputChannels() { return channels; }
+  uint16_t inputBits() { return bits; }
+
+protected:
+  enum {wav_riff, wav_chunk, wav_fmt, wav_skip, wav_data, wav_done, wav_error};
+  bool parseFmt();
+  float decodeFrame(const uint8_t* frame);
+  size_t resample(float sample, int16_t* out);
+  void fail(const char* msg);
+
+  int state;
+  const char* errMsg;
+  uint8_t hdrBuff[40]; // riff header, chunk header or fmt chunk being collected
+  size_t hdrLen; // bytes needed in hdrBuff
+  size_t hdrFill;
+  uint32_t chunkLeft; // bytes remaining of chunk being skipped or data
+  bool dataUnsized; // data chunk length not given, read to end
+  uint16_t format; // 1 PCM, 3 float
+  uint16_t channels;
+  uint16_t bits;
+  uint16_t frameBytes;
+  uint32_t inRate;
+  uint32_t outRate;
+  uint8_t frameBuff[WAV_MAX_CHANNELS * 4]; // frame split across chunks
+  size_t frameFill;
+  uint32_t phase; // 16.16 fixed point position between prevSample and currSample
+  uint32_t phaseInc;
+  float prevSample, currSample;
+  Biquad antiAlias[2];
+  bool filterOn;
+};
@@ -8,6 +8,7 @@
 /******************** User modifiable defines *******************/
 
 #define INCLUDE_RTSP false // allow RTSP (see rtsp.cpp)
+#define INCLUDE_WEB_ASSETS false // serve web page from flash, needs webAssets.h (see extras/makeWebAssets.py)
 
 #define ALLOW_SPACES false // set true to allow whitespace in configs.txt key values
 
@@ -30,13 +31,14 @@
 #define APP_NAME "VoiceChanger" // max 15 chars
 #define APP_VER "1.10"
 
-#define HTTP_CLIENTS 2 // http, ws
-#define MAX_STREAMS 0
+#define WS_CLIENTS 3 // max concurrent websockets, <= 8
+#define HTTP_CLIENTS (1 + WS_CLIENTS) // http, ws
+#define MAX_STREAMS 3 // /stream.wav listeners
 #define INDEX_PAGE_PATH DATA_DIR "/VC" HTML_EXT
 #define FILE_NAME_LEN 64
 #define IN_FILE_NAME_LEN 128
-#define JSON_BUFF_LEN (2 * 1024) // set big enough to hold json string
-#define MAX_CONFIGS 85 // > number of entries in configs.txt
+#define JSON_BUFF_LEN (4 * 1024) // set big enough to hold json string
+#define MAX_CONFIGS 110 // > number of entries in configs.txt
 #define GITHUB_PATH "/s60sc/ESP32-VoiceChanger/main"
 
 #define STORAGE LittleFS // One of LittleFS or SD_MMC
@@ -56,7 +58,7 @@
 #define ISVC // VC specific code in generics
 
 // to determine if newer data files need to be loaded
-#define CFG_VER 7
+#define CFG_VER 17
 
 #ifdef CONFIG_IDF_TARGET_ESP32S3 
 #define SERVER_STACK_SIZE (1024 * 8)
@@ -68,12 +70,19 @@
 #define STICK_STACK_SIZE (1024 * 2)
 #endif
 #define BATT_STACK_SIZE (1024 * 2)
+#define DISP_STACK_SIZE (1024 * 2)
+#define POT_STACK_SIZE (1024 * 2)
 #define EMAIL_STACK_SIZE (1024 * 6)
 #define FS_STACK_SIZE (1024 * 4)
-#define LOG_STACK_SIZE (1024 * 3)
+#define LOG_STACK_SIZE (1024 * 4)
 #define AUDIO_STACK_SIZE (1024 * 4)
 #define MQTT_STACK_SIZE (1024 * 4)
 #define PING_STACK_SIZE (1024 * 5)
+#define PROF_STACK_SIZE (1024 * 3)
+#define RENDER_STACK_SIZE (1024 * 4)
+#define STREAM_STACK_SIZE (1024 * 3)
+#define WS_STACK_SIZE (1024 * 3)
+#define UDP_STACK_SIZE (1024 * 3)
 #define SERVO_STACK_SIZE (1024)
 #define SUSTAIN_STACK_SIZE (1024 * 4)
 #define TGRAM_STACK_SIZE (1024 * 6)
@@ -85,45 +94,110 @@
 #define AUDIO_PRI 5
 #define STICK_PRI 5
 #define LED_PRI 1
+#define DISP_PRI 1
+#define POT_PRI 1
 #define SERVO_PRI 1
 #define LOG_PRI 1
+#define PROF_PRI 1
+#define RENDER_PRI 2
+#define STREAM_PRI 3
+#define WS_PRI 4
+#define UDP_PRI 4
 #define BATT_PRI 1
 
 #define FILE_EXT "wav"
 #define DMA_BUFF_LEN 1024 // used for I2S buffer size
 #define DMA_BUFF_CNT 4
-#define REVERB_SAMPLES 1600
+#define REVERB_MS 100 // comb reverb delay
 #define OSAMP 4 // 4 for moderate quality, 32 for best quality
+#define SHAPER_LEN 256 // clipping waveshaper table intervals
 #define MIC_GAIN_CENTER 3 // mid point
+#define DSP_LOAD_WARN 90 // log if filters take more than this percentage of block duration
+#define AUDIO_CHECK_SECS 5 // interval for checking audio errors
+#define BENCH_SECS 10 // default duration of benchmark test signal
+#define BENCH_TIMEOUT 60 // max secs to wait for benchmark
+#define DISP_MS 40 // lamp and led bar refresh interval
+#define POT_MS 20 // potentiometer sampling interval
+#define POT_ALPHA 0.2 // potentiometer smoothing, 0.0 (max smooth) to 1.0 (no smooth)
+#define POT_HYST 0.25 // proportion of a step that pot must move past to change setting
+#define METER_ATTACK_SECS 0.01 // rms meter attack time constant
+#define METER_RELEASE_SECS 0.3 // rms meter release time constant
+#define METER_FALL_DB 20.0 // peak meter fall rate per sec
+#define METER_RANGE_DB 48.0 // level range shown on lamp and led bar
+#define TRACE_MAX_SECS 30 // max duration of trace capture
+#define TRACE_EVENTS 8192 // trace ring size if PSRAM, power of 2
+#define TRACE_TASKS 16 // max number of tasks distinguished in trace
+#define RENDER_BLOCKS 8 // DMA blocks per offline render buffer
+#define RENDER_BUFFS 2 // number of offline render buffers
+#define RENDER_TIMEOUT 10 // max secs to wait for a render buffer
+#define WS_QUEUE_LEN 6 // websocket frames queued for sending
+#define WS_SEND_TIMEOUT 200 // ms for websocket send before slow client is closed, as sends are serial
+#define RTSP_BLOCKS 4 // audio blocks queued for RTSP sender
+#define WS_FRAME_LEN (DMA_BUFF_LEN * 2 + 16) // max websocket frame size, one audio block plus codec header
+#define WS_MERGE_LEN WS_FRAME_LEN // coalesce small binary frames up to this size, <= WS_FRAME_LEN
+#define WS_DEFAULT_TOPICS (ws_spectrum | ws_log | ws_status) // browser sends +audio to add speaker output
 
 
 
 /******************** Function declarations *******************/
 
-enum audioAction {NO_ACTION, UPDATE_CONFIG, RECORD_ACTION, PLAY_ACTION, PASS_ACTION, WAV_ACTION, STOP_ACTION};
+enum audioAction {NO_ACTION, UPDATE_CONFIG, RECORD_ACTION, PLAY_ACTION, PASS_ACTION, WAV_ACTION, STOP_ACTION, BENCH_ACTION};
 enum stepperModel {BYJ_48, BIPOLAR_8mm};
+// trace events other than DSP stages in dspProfile.h
+enum traceId {trc_mic_read = 16, trc_amp_write, trc_ws_send, trc_log_write, trc_status_req, trc_ws_recv, TRACE_IDS};
+
+#define TRACE_BEGIN(id) do { if (traceOn) traceRecord(id, 'B'); } while (0)
+#define TRACE_END(id) do { if (traceOn) traceRecord(id, 'E'); } while (0)
 
 // global app specific functions
-void applyFilters();
-void applyVolume();
+void applyFilters(size_t numSamples);
 void browserMicInput(uint8_t* wsMsg, size_t wsMsgLen);
 int8_t checkPotVol(int8_t adjVol);
 void closeI2S();
-void displayAudioLed(int16_t audioSample);
+size_t formatAudioStats(char* p);
+size_t formatBench(char* p, size_t buffLen, uint32_t httpStack);
 uint8_t getBrightness();
+float getVolumeGain();
+bool importBegin();
+const char* importEnd();
+esp_err_t importHandler(httpd_req_t* req);
+bool importWrite(const uint8_t* data, size_t len);
 void ledBarGauge(float level);
+void meterReset();
+void meterUpdate(int16_t* samples, size_t numSamples);
 void prepAudio();
 void prepPeripherals();
 void prepRTSP();
+void prepIntercom();
+bool udpActive();
+size_t udpMicInput(int16_t* dest);
+void udpWrite(int16_t* samples, size_t numSamples);
+size_t udpStats(char* p);
+void rtspWrite(const int16_t* samples, size_t numSamples);
+size_t rtspStats(char* p);
+esp_err_t processHandler(httpd_req_t* req);
+esp_err_t renderSend(httpd_req_t* req, const int16_t* src, size_t numSamples);
+esp_err_t streamHandler(httpd_req_t* req);
+void streamWrite(int16_t* samples, size_t numSamples);
+size_t profFormat(char* buff, size_t buffLen);
+size_t profJson(char* buff, size_t buffLen);
+void profReset();
 void setI2Schan(int whichChan);
 void setLamp(uint8_t lampVal);
 void setupAudioLed();
 void setupFilters();
 void setupVC();
 void setupWeb();
-void smbPitchShiftInit(float _pitchShift, long _fftFrameSize, long _osamp, float sampleRate);
-void smbPitchShift(size_t numSampsToProcess, int16_t *indata, int16_t *outdata);
+void smbFft(float *fftBuffer, long fftFrameSize, long sign);
+void spectrumBins(const float* magn, long fftFrameSize2);
+void spectrumInit(long fftFrameSize, float sampleRate);
+void spectrumUpdate(int16_t* samples, size_t numSamples);
+void startProfWs();
 void stepperDone();
+void traceRecord(int id, char phase, uint32_t durUs = 0);
+esp_err_t traceSend(httpd_req_t* req);
+bool traceStart();
+void traceStop();
 size_t updateWavHeader();
 void updateVars(const char* jsonKey, const char* jsonVal); 
 void wsJsonSend(const char* keyStr, const char* valStr);
@@ -158,6 +232,8 @@ extern int ledBarData;
 extern int switchModePin;
 extern bool volatile stopAudio;
 extern SemaphoreHandle_t audioSemaphore;
+extern SemaphoreHandle_t benchSemaphore;
+extern int benchSecs; // duration of benchmark test signal
 
 // web filter parameters
 extern bool RING_MOD;
@@ -169,6 +245,13 @@ extern bool LOW_SHELF;
 extern bool PEAK;
 extern bool CLIPPING;
 extern bool REVERB;
+extern bool DELAY_LINE;
+extern bool NOISE_SUPP;
+extern bool VOCODER;
+extern bool DITHER;
+extern bool DSP_PROFILE; // collect per stage DSP timings
+extern int PROF_WS_SECS; // interval for profile websocket message
+extern bool traceOn; // recording trace events
 extern float BP_Q;    // sharpness of filter
 extern float BP_FREQ; // center frequency for band pass
 extern uint16_t BP_CAS; // number of cascaded filters
@@ -190,6 +273,21 @@ extern uint8_t SW_AMP;    // amplitude of generated sine wave
 extern int CLIP_FACTOR; // factor used to compress high volume
 extern int DECAY_FACTOR; // factor used control reverb decay
 extern float PITCH_SHIFT; // factor used shift pitch up or down
+extern int DELAY_TYPE; // delay effect preset
+extern int DELAY_MIX; // level of delayed signal
+extern int RV_TYPE; // reverb type: comb or FDN
+extern int RV_SIZE; // FDN reverb room size
+extern int RV_DAMP; // FDN reverb damping
+extern uint32_t reverbTime; // reverb processing time per block in us
+extern int NS_LEVEL; // noise suppression level
+extern int VOC_BANDS; // number of vocoder bands
+extern int VOC_CARRIER; // vocoder carrier type
+extern int VOC_FREQ; // vocoder sawtooth frequency
+extern int SPEC_FPS; // spectrum frames per sec sent to browser
+extern int WS_CODEC; // codec for browser speaker audio
+extern int UDP_PORT; // UDP intercom port, 0 for none
+extern uint32_t vocoderTime; // vocoder processing time per block in us
+extern int vocoderBands; // bands used by live vocoder
 
 // other web settings
 extern int micGain; // microphone preamplification factor
@@ -222,6 +320,7 @@ extern uint16_t rtpSubtitlesPort;
 extern char RTP_ip[];
 extern uint8_t rtspMaxClients;
 extern uint8_t rtpTTL;
+extern int rtspPtime; // ms of audio per RTP packet
 extern char RTSP_Name[];
 extern char RTSP_Pass[];
 
@@ -9,6 +9,7 @@
 // s60sc 2021, 2023, 2024
 
 #include "appGlobals.h"
+#include <atomic>
 
 const size_t prvtkey_len = 0;
 const size_t cacert_len = 0;
@@ -32,6 +33,7 @@ bool DISABLE = false; // temporarily disable filter settings on browser
 bool USE_POT = false; // whether external volume / brightness control potentiometer being used
 volatile audioAction THIS_ACTION = NO_ACTION;
 SemaphoreHandle_t audioSemaphore = NULL; // disables interrupts whilst state change occuring
+SemaphoreHandle_t benchSemaphore = NULL; // signals benchmark complete
 
 // n/a
 bool streamVid = false;
@@ -71,33 +73,120 @@ void IRAM_ATTR stopISR() {
   stopAudio = true;
 }
 
+/************************ potentiometer *************************/
+
+// pot settings published by potTask, -1 if not yet read
+static std::atomic<int8_t> potVol(-1);
+static std::atomic<int8_t> potBright(-1);
+
+static int potStep(float smoothed, int prevStep, int stepSize) {
+  // quantise smoothed reading, only changing step if moved past hysteresis margin
+  float stepPos = smoothed / stepSize;
+  if (prevStep < 0 || stepPos > prevStep + 1 + POT_HYST || stepPos < prevStep - POT_HYST) return (int)stepPos;
+  return prevStep;
+}
+
+static void potTask(void* arg) {
+  // sample pot in background so audio task is not delayed by ADC reads
+  float smoothed = -1;
+  int volStep = -1;
+  int brightStep = -1;
+  while (true) {
+    if (USE_POT && switchModePin > 0) {
+      float reading = analogRead(sanalogPin);
+      smoothed = smoothed < 0 ? reading : smoothSensor(reading, smoothed, POT_ALPHA);
+      // switch selects whether pot used for volume (high) or brightness (low)
+      if (digitalRead(switchModePin)) {
+        volStep = potStep(smoothed, volStep, 256); // 0 .. 15, as analog is 12 bits
+        potVol.store(volStep);
+      } else {
+        brightStep = potStep(smoothed, brightStep, 512); // 0 .. 7
+        potBright.store(brightStep);
+      }
+    }
+    delay(POT_MS);
+  }
+}
+
+static void startPotTask() {
+  if (sanalogPin > 0) xTaskCreate(potTask, "potTask", POT_STACK_SIZE, NULL, POT_PRI, NULL);
+}
+
 uint8_t getBrightness() {
   // get required led output brightness (0 .. 7) from analog control if selected
   // else use web page setting
-  static uint8_t saveBright = BRIGHTNESS;
-  if (USE_POT && switchModePin) {
-    // use current pot setting if active, else use previous value
-    if (!digitalRead(switchModePin)) saveBright = (smoothAnalog(sanalogPin) >> 9); // (0 .. 8)
-    return saveBright * 2;
-  } else return BRIGHTNESS * 2; // use web value
+  int8_t bright = potBright.load();
+  if (USE_POT && switchModePin > 0 && bright >= 0) return bright * 2; // latest pot setting for brightness
+  return BRIGHTNESS * 2; // use web value
 }
 
 int8_t checkPotVol(int8_t adjVol) {
-  if (USE_POT && switchModePin > 0) {
-    // update saveVol if pot switched to volume control
-    if (digitalRead(switchModePin)) adjVol = (smoothAnalog(sanalogPin) >> 8); // 0 .. 15, as analog is 12 bits
-  }
+  // use latest pot setting for volume if available
+  int8_t vol = potVol.load();
+  if (USE_POT && switchModePin > 0 && vol >= 0) adjVol = vol;
   return adjVol;
 }
 
-void displayAudioLed(int16_t audioSample) {
-  if (lampPin || ledBarUse) {
-    audioSample = audioSample == SHRT_MIN ? abs(++audioSample) : abs(audioSample);
-    float ledLevel = (float)(audioSample) / SHRT_MAX;
-    // use sample of sound level for single LED brightness by setting PWM duty cycle
-    setLamp((uint8_t)(ledLevel * getBrightness()));
-    // use sample of sound level to display on MY9921 controlled LED bar as gauge (PPM meter)
-    ledBarGauge(ledLevel);
+/************************ audio level meter *************************/
+
+// block RMS and peak levels with ballistics, each 0 .. 65535 for 0 .. full scale, 
+// packed together so that the display task reads a consistent pair
+static std::atomic<uint32_t> meterLevels(0);
+static float meterRms = 0;
+static float meterPeak = 0;
+
+void meterUpdate(int16_t* samples, size_t numSamples) {
+  // called from audio task for each output block
+  if (!(lampPin || ledBarUse) || !numSamples) return;
+  int64_t sumSq = 0;
+  int32_t peak = 0;
+  for (size_t i = 0; i < numSamples; i++) {
+    sumSq += (int32_t)samples[i] * samples[i];
+    peak = std::max(peak, abs((int32_t)samples[i]));
+  }
+  float blockRms = sqrt((float)sumSq / numSamples) / 32768;
+  float blockPeak = peak / 32768.0;
+  float blockSecs = (float)numSamples / SAMPLE_RATE;
+  // rms follows level with separate attack and release times
+  float coeff = 1 - exp(-blockSecs / (blockRms > meterRms ? METER_ATTACK_SECS : METER_RELEASE_SECS));
+  meterRms += coeff * (blockRms - meterRms);
+  // peak rises immediately, then falls at a fixed rate in dB
+  if (blockPeak > meterPeak) meterPeak = blockPeak;
+  else meterPeak *= pow(10, -METER_FALL_DB * blockSecs / 20);
+  meterLevels.store((uint32_t)(meterRms * 65535) << 16 | (uint32_t)(meterPeak * 65535));
+}
+
+void meterReset() {
+  meterRms = meterPeak = 0;
+  meterLevels.store(0);
+}
+
+static float meterScale(uint16_t level) {
+  // convert level to proportion of display range in dB
+  if (!level) return 0;
+  return constrain(1 + 20 * log10(level / 65535.0) / METER_RANGE_DB, 0, 1);
+}
+
+static void displayTask(void* arg) {
+  // refresh lamp and led bar from meter at fixed rate, off the audio task
+  uint8_t prevLamp = 0xFF;
+  uint8_t prevBar = 0xFF;
+  while (true) {
+    uint32_t levels = meterLevels.load();
+    if (lampPin) {
+      // rms level sets single LED brightness by PWM duty cycle
+      uint8_t lampVal = (uint8_t)(meterScale(levels >> 16) * getBrightness());
+      if (lampVal != prevLamp) setLamp(lampVal);
+      prevLamp = lampVal;
+    }
+    if (ledBarUse) {
+      // peak level displayed on MY9921 controlled LED bar as gauge (PPM meter)
+      float barLevel = meterScale(levels & 0xFFFF);
+      uint8_t barVal = (uint8_t)(barLevel * 80); // 8 brightness steps per led
+      if (barVal != prevBar) ledBarGauge(barLevel);
+      prevBar = barVal;
+    }
+    delay(DISP_MS);
   }
 }
 
@@ -108,6 +197,7 @@ void setupAudioLed() {
   ledBarUse = (ledBarClock && ledBarData) ? true : false;
   // setup PWM controlled single LED
   lampPin = saudioLedPin;
+  if (lampPin || ledBarUse) xTaskCreate(displayTask, "displayTask", DISP_STACK_SIZE, NULL, DISP_PRI, NULL);
 }
 
 void setupVC() {
@@ -129,40 +219,195 @@ void setupVC() {
     attachInterrupt(digitalPinToInterrupt(buttonStopPin), stopISR, FALLING);
   }
   if (switchModePin > 0) pinMode(switchModePin, INPUT_PULLUP);
+  startPotTask();
 
   audioSemaphore = xSemaphoreCreateBinary();
+  benchSemaphore = xSemaphoreCreateBinary();
   prepAudio(); // report on device status
   xSemaphoreGive(audioSemaphore);
 }
 
 static void doDownload(httpd_req_t* req) {
-  // download recording to browser, applying current filters
-  if (psramFound()) {
-    size_t downloadBytes = updateWavHeader();
-    setupFilters();
+  // download recording to browser, rendered offline with current filters
+  if (psramFound() && recAudioBuffer != NULL) {
+    size_t downloadBytes = updateWavHeader(); // header copied to audioBuffer
     httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
     httpd_resp_set_type(req, "application/octet");
     httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=VoiceChanger.wav");
-    char contentLength[10];
-    sprintf(contentLength, "%i", downloadBytes);
-    httpd_resp_set_hdr(req, "Content-Length", contentLength);
     if (downloadBytes) {
-      // use chunked encoding 
-      httpd_resp_send_chunk(req, (char*)audioBuffer, WAV_HDR_LEN);
-      size_t chunksize = 0, ramPtr = WAV_HDR_LEN;
-      do {
-        chunksize = std::min((size_t)DMA_BUFF_LEN, downloadBytes - ramPtr); 
-        memcpy(sampleBuffer, audioBuffer + ramPtr, chunksize);
-        applyFilters();
-        if (httpd_resp_send_chunk(req, (char*)sampleBuffer, chunksize) != ESP_OK) break;  
-        ramPtr += chunksize;
-      } while (chunksize != 0);
-      LOG_INF("Downloaded recording, size: %0.1fkB", (float)(downloadBytes/1024.0));
+      // use chunked encoding, so no content length
+      if (httpd_resp_send_chunk(req, (char*)audioBuffer, WAV_HDR_LEN) == ESP_OK
+        && renderSend(req, (int16_t*)(recAudioBuffer + WAV_HDR_LEN), downloadBytes / sizeof(int16_t)) == ESP_OK)
+        LOG_INF("Downloaded recording, size: %0.1fkB", (float)((downloadBytes + WAV_HDR_LEN) / 1024.0));
     } else LOG_WRN("Recorded content is empty");
     httpd_resp_sendstr_chunk(req, NULL); // signal end of data
   } else LOG_WRN("PSRAM and recording needed for download"); 
 }
 
+static bool benchBusy = false;
+static int benchReqSecs = 0;
+static uint32_t benchHttpStack = 0;
+
+static void benchTask(void* arg) {
+  // run current filters offline in audio task and return timings as json
+  // uses recording if present, else test signal of benchReqSecs duration
+  httpd_req_t* req = (httpd_req_t*)arg;
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  stopAudio = true; // stop any current action
+  wsAsyncSendText("#M0"); // stop browser mic sending
+  if (xSemaphoreTake(audioSemaphore, pdMS_TO_TICKS(1000)) == pdTRUE) {
+    benchSecs = benchReqSecs > 0 ? benchReqSecs : BENCH_SECS;
+    THIS_ACTION = BENCH_ACTION;
+    xSemaphoreTake(benchSemaphore, 0); // clear any previous signal
+    xTaskNotifyGive(audioHandle);
+    if (xSemaphoreTake(benchSemaphore, pdMS_TO_TICKS(BENCH_TIMEOUT * 1000)) == pdTRUE) {
+      // own buffer as jsonBuff used by web server meanwhile
+      char* benchJson = (char*)malloc(JSON_BUFF_LEN);
+      if (benchJson != NULL) {
+        formatBench(benchJson, JSON_BUFF_LEN, benchHttpStack);
+        httpd_resp_sendstr(req, benchJson);
+        free(benchJson);
+      } else httpd_resp_sendstr(req, "{\"error\":\"memory\"}");
+    } else {
+      stopAudio = true;
+      LOG_WRN("Benchmark timed out");
+      httpd_resp_sendstr(req, "{\"error\":\"timeout\"}");
+    }
+  } else {
+    LOG_WRN("Waiting for previous action to terminate");
+    httpd_resp_sendstr(req, "{\"error\":\"busy\"}");
+  }
+  httpd_req_async_handler_complete(req);
+  benchBusy = false;
+  vTaskDelete(NULL);
+}
+
+static esp_err_t doBench(httpd_req_t* req, int testSecs) {
+  // benchmark waits in own task so web server is not held up
+  httpd_resp_set_type(req, "application/json");
+  if (benchBusy) {
+    httpd_resp_sendstr(req, "{\"error\":\"busy\"}");
+    return ESP_OK;
+  }
+  benchReqSecs = testSecs;
+  benchHttpStack = checkStackUse(xTaskGetCurrentTaskHandle(), 1);
+  httpd_req_t* asyncReq;
+  if (httpd_req_async_handler_begin(req, &asyncReq) != ESP_OK) return ESP_FAIL;
+  benchBusy = true;
+  if (xTaskCreate(benchTask, "benchTask", RENDER_STACK_SIZE, asyncReq, RENDER_PRI, NULL) != pdPASS) {
+    LOG_WRN("Failed to start benchmark task");
+    benchBusy = false;
+    httpd_req_async_handler_complete(asyncReq);
+    httpd_resp_sendstr(req, "{\"error\":\"unavailable\"}");
+    return ESP_OK;
+  }
+  return ESP_ERR_NOT_FINISHED; // response sent by benchTask
+}
+
+static int traceReqSecs = 0;
+
+static void traceTask(void* arg) {
+  // wait for trace capture to complete, then return as chrome trace json
+  httpd_req_t* req = (httpd_req_t*)arg;
+  delay(traceReqSecs * 1000);
+  traceStop();
+  if (traceSend(req) != ESP_OK) httpd_resp_sendstr_chunk(req, NULL); // signal end of data
+  httpd_req_async_handler_complete(req);
+  vTaskDelete(NULL);
+}
+
+static esp_err_t doTrace(httpd_req_t* req, int traceSecs) {
+  // record trace of current activity for traceSecs, waiting in own task
+  // so that web server activity is not held up and is included in trace
+  httpd_req_t* asyncReq = NULL;
+  if (traceStart()) {
+    traceReqSecs = constrain(traceSecs, 1, TRACE_MAX_SECS);
+    if (httpd_req_async_handler_begin(req, &asyncReq) == ESP_OK) {
+      if (xTaskCreate(traceTask, "traceTask", RENDER_STACK_SIZE, asyncReq, RENDER_PRI, NULL) == pdPASS) return ESP_ERR_NOT_FINISHED;
+      LOG_WRN("Failed to start trace task");
+      httpd_req_async_handler_complete(asyncReq);
+    }
+    traceStop();
+  }
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_sendstr(req, "{\"error\":\"unavailable\"}");
+  return ESP_OK;
+}
+
+static bool importLock() {
+  // stop any current action and hold audio task while recording replaced
+  stopAudio = true;
+  wsAsyncSendText("#M0"); // stop browser mic sending
+  if (xSemaphoreTake(audioSemaphore, pdMS_TO_TICKS(1000)) == pdTRUE) return true;
+  LOG_WRN("Waiting for previous action to terminate");
+  return false;
+}
+
+static void importResult(httpd_req_t* req, const char* errMsg) {
+  // report outcome of import to browser
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  if (errMsg == NULL) snprintf(jsonBuff, JSON_BUFF_LEN, "Imported %0.1f secs as recording", (float)(recAudioBytes - WAV_HDR_LEN) / sizeof(int16_t) / SAMPLE_RATE);
+  else {
+    httpd_resp_set_status(req, "415 Unsupported Media Type");
+    snprintf(jsonBuff, JSON_BUFF_LEN, "Import failed: %s", errMsg);
+  }
+  httpd_resp_sendstr(req, jsonBuff);
+}
+
+static void doImport(httpd_req_t* req, const char* fileName) {
+  // import WAV file on storage as recording, converted in chunks as read
+  const char* errMsg = "File not found";
+  File wavFile = STORAGE.open(fileName, FILE_READ);
+  if (wavFile) {
+    errMsg = "Busy";
+    if (importLock()) {
+      errMsg = "PSRAM needed";
+      if (importBegin()) {
+        size_t bytesRead;
+        do bytesRead = wavFile.read((uint8_t*)jsonBuff, JSON_BUFF_LEN);
+        while (bytesRead && importWrite((uint8_t*)jsonBuff, bytesRead));
+        errMsg = importEnd();
+      }
+      xSemaphoreGive(audioSemaphore);
+    }
+    wavFile.close();
+  }
+  importResult(req, errMsg);
+}
+
+esp_err_t importHandler(httpd_req_t* req) {
+  // import WAV file uploaded from browser as recording, converted in chunks as received
+  const char* errMsg = "Busy";
+  size_t remaining = req->content_len;
+  if (importLock()) {
+    errMsg = "PSRAM needed";
+    if (importBegin()) {
+      bool wanted = true;
+      while (remaining) {
+        int bytesRead = httpd_req_recv(req, jsonBuff, std::min(remaining, (size_t)JSON_BUFF_LEN));
+        if (bytesRead == HTTPD_SOCK_ERR_TIMEOUT) continue;
+        if (bytesRead <= 0) {
+          LOG_WRN("Import upload failed with status %i", bytesRead);
+          break;
+        }
+        remaining -= bytesRead;
+        // rest of upload discarded once buffer full or end of WAV data
+        if (wanted) wanted = importWrite((uint8_t*)jsonBuff, bytesRead);
+      }
+      errMsg = importEnd();
+    }
+    xSemaphoreGive(audioSemaphore);
+  }
+  if (remaining) {
+    // connection cannot be reused with unread content
+    httpd_resp_set_hdr(req, "Connection", "close");
+    if (errMsg == NULL) errMsg = "Upload incomplete";
+  }
+  importResult(req, errMsg);
+  return ESP_OK;
+}
+
 /************************ webServer callbacks *************************/
 
 bool updateAppStatus(const char* variable, const char* value, bool fromUser) {
@@ -179,7 +424,11 @@ bool updateAppStatus(const char* variable, const char* value, bool fromUser) {
   else if (!strcmp(variable, "LS")) LOW_SHELF = (bool)intVal;
   else if (!strcmp(variable, "PK")) PEAK = (bool)intVal;
   else if (!strcmp(variable, "CP")) CLIPPING = (bool)intVal;
+  else if (!strcmp(variable, "Dither")) DITHER = (bool)intVal;
   else if (!strcmp(variable, "RV")) REVERB = (bool)intVal;
+  else if (!strcmp(variable, "DL")) DELAY_LINE = (bool)intVal;
+  else if (!strcmp(variable, "NS")) NOISE_SUPP = (bool)intVal;
+  else if (!strcmp(variable, "VO")) VOCODER = (bool)intVal;
   // integer
   else if (!strcmp(variable, "BPcas")) BP_CAS = intVal;
   else if (!strcmp(variable, "HPcas")) HP_CAS = intVal;
@@ -188,6 +437,28 @@ bool updateAppStatus(const char* variable, const char* value, bool fromUser) {
   else if (!strcmp(variable, "SineAmp")) SW_AMP = intVal << 5;
   else if (!strcmp(variable, "ClipFac")) CLIP_FACTOR = intVal;
   else if (!strcmp(variable, "DecayFac")) DECAY_FACTOR = intVal;
+  else if (!strcmp(variable, "DLtype")) DELAY_TYPE = intVal;
+  else if (!strcmp(variable, "DLmix")) DELAY_MIX = intVal;
+  else if (!strcmp(variable, "RVtype")) RV_TYPE = intVal;
+  else if (!strcmp(variable, "RVsize")) RV_SIZE = intVal;
+  else if (!strcmp(variable, "RVdamp")) RV_DAMP = intVal;
+  else if (!strcmp(variable, "NSlevel")) NS_LEVEL = intVal;
+  else if (!strcmp(variable, "VObands")) VOC_BANDS = intVal;
+  else if (!strcmp(variable, "VOcarrier")) VOC_CARRIER = intVal;
+  else if (!strcmp(variable, "VOfreq")) VOC_FREQ = intVal;
+  else if (!strcmp(variable, "WScodec")) WS_CODEC = intVal;
+  else if (!strcmp(variable, "UDPport")) UDP_PORT = intVal; // applied on reboot
+#if INCLUDE_RTSP
+  // applied on reboot
+  else if (!strcmp(variable, "RTSPptime")) rtspPtime = intVal;
+  else if (!strcmp(variable, "RTSPclients")) rtspMaxClients = intVal;
+  else if (!strcmp(variable, "RTSPttl")) rtpTTL = intVal;
+#endif
+  else if (!strcmp(variable, "SPfps")) SPEC_FPS = intVal; // buffer setup by audio task when needed
+  else if (!strcmp(variable, "ProfWs")) {
+    PROF_WS_SECS = intVal;
+    startProfWs();
+  }
   else if (!strcmp(variable, "micGain")) micGain = intVal;
   else if (!strcmp(variable, "ampVol")) ampVol = intVal; 
   else if (!strcmp(variable, "Bright")) BRIGHTNESS = intVal;
@@ -206,6 +477,10 @@ bool updateAppStatus(const char* variable, const char* value, bool fromUser) {
   // bool
   else if (!strcmp(variable, "Disable")) DISABLE = (bool)intVal;
   else if (!strcmp(variable, "VolPot")) USE_POT = (bool)intVal;
+  else if (!strcmp(variable, "Profile")) {
+    DSP_PROFILE = (bool)intVal;
+    if (DSP_PROFILE) profReset();
+  }
   else if (!strcmp(variable, "mType")) I2Smic = bool(intVal);
   else if (!strcmp(variable, "micRem")) {
     micRem = bool(intVal);
@@ -284,6 +559,24 @@ void wsJsonSend(const char* keyStr, const char* valStr) {
 void buildAppJsonString(bool filter) {
   // build app specific part of json string
   char* p = jsonBuff + 1;
+  // reverb processing time per block, and as percentage of block duration
+  float blockUs = DMA_BUFF_LEN * 1000000.0 / SAMPLE_RATE;
+  p += sprintf(p, "\"RVload\":\"%luus (%0.1f%%)\",", reverbTime, reverbTime * 100.0 / blockUs);
+  // vocoder time per band, with estimate of max bands that can run in real time
+  float bandUs = VOCODER && vocoderBands ? (float)vocoderTime / vocoderBands : 0;
+  p += sprintf(p, "\"VOload\":\"%0.1fus/band (max %d bands)\",", bandUs, bandUs > 0 ? (int)(blockUs / bandUs) : 0);
+  p += formatAudioStats(p);
+  p += wsQueueStats(p);
+  p += udpStats(p);
+#if INCLUDE_RTSP
+  p += rtspStats(p);
+#endif
+  if (DSP_PROFILE) {
+    // per stage timings
+    p += sprintf(p, "\"DSPprof\":\"");
+    p += profFormat(p, 512);
+    p += sprintf(p, "\",");
+  }
   *p = 0;
 }
 
@@ -293,6 +586,7 @@ esp_err_t appSpecificWebHandler(httpd_req_t* req, const char* variable, const ch
   if (!strcmp(variable, "action")) {
     if (intVal == UPDATE_CONFIG) updateStatus("save", "1"); // save current status in config
     else if (intVal == WAV_ACTION) doDownload(req);
+    else if (intVal == BENCH_ACTION) return doBench(req, 0);
     else {
       // action request, allow return to web handler immediately,
       // otherwise if action takes too long, watchdog would be triggered
@@ -302,7 +596,10 @@ esp_err_t appSpecificWebHandler(httpd_req_t* req, const char* variable, const ch
       if ((THIS_ACTION != STOP_ACTION) && (xSemaphoreTake(audioSemaphore, pdMS_TO_TICKS(200)) == pdTRUE)) xTaskNotifyGive(audioHandle);
       else LOG_WRN("Waiting for previous action to terminate");
     }
-  } else return ESP_FAIL;
+  } else if (!strcmp(variable, "bench")) return doBench(req, intVal);
+  else if (!strcmp(variable, "trace")) return doTrace(req, intVal);
+  else if (!strcmp(variable, "import")) doImport(req, value);
+  else return ESP_FAIL;
   return ESP_OK;
 }
 
@@ -358,8 +655,29 @@ LPcas~1~98~T~n/a
 PKqval~0.7~98~T~n/a
 CP~0~98~T~n/a
 ClipFac~1~98~T~n/a
+Dither~0~98~T~n/a
 RV~0~98~T~n/a
 DecayFac~1~98~T~n/a
+DL~0~98~T~n/a
+DLtype~0~98~T~n/a
+DLmix~5~98~T~n/a
+RVtype~1~98~T~n/a
+RVsize~5~98~T~n/a
+RVdamp~5~98~T~n/a
+NS~0~98~T~n/a
+NSlevel~4~98~T~n/a
+VO~0~98~T~n/a
+VObands~16~98~T~n/a
+VOcarrier~0~98~T~n/a
+VOfreq~110~98~T~n/a
+Profile~0~98~T~n/a
+ProfWs~0~98~T~n/a
+SPfps~15~98~T~n/a
+WScodec~0~98~T~n/a
+UDPport~0~98~T~n/a
+RTSPptime~20~98~T~n/a
+RTSPclients~1~98~T~n/a
+RTSPttl~1~98~T~n/a
 RM~0~98~T~n/a
 SineFreq~80~98~T~n/a
 SineAmp~5~98~T~n/a
@@ -28,6 +28,9 @@
 
 #if INCLUDE_AUDIO 
 
+#include "AudioCodec.h"
+#include "WavConvert.h"
+
 #include <ESP_I2S.h>
 I2SClass I2Spdm;
 I2SClass I2Sstd;
@@ -76,7 +79,11 @@ const size_t sampleBytes = DMA_BUFF_LEN * sampleWidth;
 int16_t* sampleBuffer = NULL;
 static uint8_t* wsBuffer = NULL;
 static size_t wsBufferLen = 0;
-uint8_t* audioBuffer = NULL; // mic input streamed to NVR or RTSP
+static uint8_t* wsCodecBuff = NULL; // encoded frame for browser speaker
+static codecState wsTx; // browser speaker frame sequence and ADPCM state
+static codecState wsRx; // browser mic frame sequence, lost count included in audio errors
+int WS_CODEC = codec_pcm; // codec for browser speaker audio
+uint8_t* audioBuffer = NULL; // mic input streamed to NVR
 size_t audioBytes = 0; 
 
 static const char* micLabels[2] = {"PDM", "I2S"};
@@ -94,27 +101,49 @@ static File wavFile;
 uint8_t* recAudioBuffer = NULL;
 size_t recAudioBytes = 0; 
 #endif
+
+// audio health counters, reset at start of each action
+static volatile uint32_t rxOverruns = 0; // I2S receive DMA buffers dropped
+static uint32_t txLate = 0; // amp output not written before previous output finished
+static uint32_t shortReads = 0; // esp mic reads less than full block
+static uint32_t wsDropped = 0; // browser mic frames discarded as previous one unused
+static float dspLoad = 0; // smoothed fraction of block duration used by filters
+static float dspPeak = 0; // max fraction since last check
+static uint32_t txDeadline = 0; // time when queued amp output expected to run out
+
 static uint8_t wavHeader[WAV_HDR_LEN] = { // WAV header template
   0x52, 0x49, 0x46, 0x46, 0x00, 0x00, 0x00, 0x00, 0x57, 0x41, 0x56, 0x45, 0x66, 0x6D, 0x74, 0x20,
   0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x11, 0x2B, 0x00, 0x00, 0x11, 0x2B, 0x00, 0x00,
   0x02, 0x00, 0x10, 0x00, 0x64, 0x61, 0x74, 0x61, 0x00, 0x00, 0x00, 0x00,
 };
 
-void applyVolume() {
-  // determine required volume setting
+float getVolumeGain() {
+  // determine required volume setting as linear gain
   int8_t adjVol = ampVol * 2; // use web page setting
 #ifdef ISVC
   adjVol = checkPotVol(adjVol);  // use potentiometer setting if available
 #endif
-  if (adjVol) {
-    // increase or reduce volume, 6 is unity eg midpoint of pot / web slider
-    adjVol = adjVol > 5 ? adjVol - 5 : adjVol - 7; 
-    // apply volume control to samples
-    for (int i = 0; i < DMA_BUFF_LEN; i++) {   
-      // apply volume control 
-      sampleBuffer[i] = adjVol < 0 ? sampleBuffer[i] / abs(adjVol) : constrain((int32_t)sampleBuffer[i] * adjVol, SHRT_MIN, SHRT_MAX);
-    }
-  } // else turn off volume
+  if (!adjVol) return 1.0; // volume control off
+  // increase or reduce volume, 6 is unity eg midpoint of pot / web slider
+  adjVol = adjVol > 5 ? adjVol - 5 : adjVol - 7; 
+  return adjVol < 0 ? 1.0 / abs(adjVol) : adjVol;
+}
+
+static bool IRAM_ATTR rxOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+  // I2S receive queue full, so oldest DMA buffer discarded
+  rxOverruns++;
+  return false;
+}
+
+static void watchRxOverrun(I2SClass& i2s) {
+  // register callback for receive overrun, only allowed while channel disabled
+  i2s_chan_handle_t rxHandle = i2s.rxChan();
+  if (rxHandle == NULL) return;
+  i2s_event_callbacks_t cbs = {};
+  cbs.on_recv_q_ovf = rxOverflow;
+  i2s_channel_disable(rxHandle);
+  if (i2s_channel_register_event_callback(rxHandle, &cbs, NULL) != ESP_OK) LOG_WRN("Unable to monitor I2S receive overruns");
+  i2s_channel_enable(rxHandle);
 }
 
 static bool setupMic() {
@@ -133,6 +162,7 @@ static bool setupMic() {
     I2Spdm.setPinsPdmRx(micSWsPin, micSdPin);
     res = I2Spdm.begin(I2S_MODE_PDM_RX, SAMPLE_RATE, I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO, I2S_STD_SLOT_LEFT);
   }
+  if (res) watchRxOverrun(I2Smic ? I2Sstd : I2Spdm);
   return res;
 }
 
@@ -152,10 +182,12 @@ void closeI2S() {
 }
 
 static void applyMicGain(size_t bytesRead) {
-  // change esp mic gain by required factor
-  uint8_t gainFactor = pow(2, micGain - MIC_GAIN_CENTER);
+  // change esp mic gain by required power of 2, up or down
+  int gainShift = micGain - MIC_GAIN_CENTER;
+  if (!gainShift) return;
   for (int i = 0; i < bytesRead / sampleWidth; i++) {
-    sampleBuffer[i] = constrain(sampleBuffer[i] * gainFactor, SHRT_MIN, SHRT_MAX);
+    if (gainShift > 0) sampleBuffer[i] = constrain((int32_t)sampleBuffer[i] * (1 << gainShift), SHRT_MIN, SHRT_MAX);
+    else sampleBuffer[i] >>= -gainShift;
   }
 }
 
@@ -163,7 +195,10 @@ static size_t espMicInput() {
   // read esp mic
   size_t bytesRead = 0;
   if (micUse) {
+    TRACE_BEGIN(trc_mic_read);
     bytesRead = I2Smic ? I2Sstd.readBytes((char*)sampleBuffer, sampleBytes) : I2Spdm.readBytes((char*)sampleBuffer, sampleBytes);
+    TRACE_END(trc_mic_read);
+    if (bytesRead < sampleBytes) shortReads++;
     applyMicGain(bytesRead);
   }
   return bytesRead;
@@ -186,42 +221,95 @@ size_t updateWavHeader() {
 
 #ifdef ISVC
 
+static void resetAudioStats() {
+  rxOverruns = txLate = shortReads = wsDropped = wsRx.lost = 0;
+  wsRx.synced = false;
+  dspLoad = dspPeak = 0;
+  txDeadline = 0;
+}
+
+static void checkAudioStats() {
+  // periodically log if load too high or audio errors occurred
+  static uint32_t lastCheck = 0;
+  static uint32_t prevErrs[5] = {0};
+  if (millis() - lastCheck < AUDIO_CHECK_SECS * 1000) return;
+  lastCheck = millis();
+  uint32_t errs[5] = {rxOverruns, txLate, shortReads, wsDropped, wsRx.lost};
+  if (memcmp(errs, prevErrs, sizeof(errs)))
+    LOG_WRN("Audio errors in last %us: rx overrun %lu, tx late %lu, short read %lu, ws dropped %lu, ws lost %lu", AUDIO_CHECK_SECS,
+      errs[0] - prevErrs[0], errs[1] - prevErrs[1], errs[2] - prevErrs[2], errs[3] - prevErrs[3], errs[4] - prevErrs[4]);
+  if (dspPeak * 100 > DSP_LOAD_WARN) LOG_WRN("DSP load peaked at %0.0f%% of block, average %0.0f%%", dspPeak * 100, dspLoad * 100);
+  memcpy(prevErrs, errs, sizeof(errs));
+  dspPeak = 0;
+}
+
+size_t formatAudioStats(char* p) {
+  // DSP load and audio error counters as json for web page
+  char* start = p;
+  p += sprintf(p, "\"DSPload\":\"%0.0f%% (peak %0.0f%%)\",", dspLoad * 100, dspPeak * 100);
+  p += sprintf(p, "\"AudioErr\":\"rx overrun %lu, tx late %lu, short read %lu, ws dropped %lu, ws lost %lu\",", 
+    rxOverruns, txLate, shortReads, wsDropped, wsRx.lost);
+  return p - start;
+}
+
 #if !INCLUDE_RTSP
 bool rtspAudio = false;
 #endif
 
 static size_t micInput() {
-  // get input from browser mic or else esp mic
+  // get input from UDP intercom client, browser mic or else esp mic
+  if (udpActive()) {
+    size_t bytesRead = udpMicInput(sampleBuffer) * sampleWidth;
+    if (bytesRead) applyMicGain(bytesRead);
+    return bytesRead;
+  }
   size_t bytesRead = (micRem) ? wsBufferLen : espMicInput();
   if (bytesRead && micRem) {
     // double buffer browser mic input
     memcpy(sampleBuffer, wsBuffer, bytesRead);
     wsBufferLen = 0;
     applyMicGain(bytesRead);
-  } else if (micRem) delay(20);
+  } else if (!bytesRead) delay(20); // no input yet, or no mic while waiting for UDP client
   return bytesRead;
 }
 
 void browserMicInput(uint8_t* wsMsg, size_t wsMsgLen) {
   // input from browser mic via websocket
-  if (micRem && !wsBufferLen) {
-    // copy browser mic input into sampleBuffer for amp
-    wsBufferLen = wsMsgLen;
-    memcpy(wsBuffer, wsMsg, wsMsgLen);
+  if (micRem) {
+    if (!wsBufferLen) {
+      // decode browser mic input ready to copy into sampleBuffer for amp
+      wsBufferLen = codecDecode(&wsRx, wsMsg, wsMsgLen, (int16_t*)wsBuffer, MAX_PAYLOAD_LEN / sampleWidth) * sampleWidth;
+    } else wsDropped++; // previous frame not yet processed
   }
 }
 
 static void ampOutput(size_t bytesRead = sampleBytes) {
   // output to amplifier, apply required filtering and volume
-  applyFilters();
-  if (spkrRem) wsAsyncSendBinary((uint8_t*)sampleBuffer, bytesRead); // browser speaker
-  else if (ampUse) I2Sstd.write((uint8_t*)sampleBuffer, bytesRead); // esp amp speaker
-  if (!audioBytes) {
-    // fill audio buffer to send to RTSP
-    memcpy(audioBuffer, sampleBuffer, bytesRead);
-    audioBytes = bytesRead;
+  uint32_t blockUs = (uint64_t)bytesRead * 1000000 / sampleWidth / SAMPLE_RATE;
+  uint32_t dspStart = micros();
+  applyFilters(bytesRead / sampleWidth);
+  float load = (float)(micros() - dspStart) / blockUs;
+  dspLoad = dspLoad * 0.9 + load * 0.1;
+  if (load > dspPeak) dspPeak = load;
+  if (wsSubscribed(ws_audio)) // browser speakers
+    wsAsyncSendBinary(wsCodecBuff, codecEncode(&wsTx, WS_CODEC, sampleBuffer, bytesRead / sampleWidth, wsCodecBuff), true);
+  udpWrite(sampleBuffer, bytesRead / sampleWidth); // UDP intercom client
+  if (ampUse && !spkrRem) {
+    // esp amp speaker, late if previous output already played out
+    uint32_t writeStart = micros();
+    if (txDeadline && (int32_t)(writeStart - txDeadline) > 0) txLate++;
+    TRACE_BEGIN(trc_amp_write);
+    I2Sstd.write((uint8_t*)sampleBuffer, bytesRead); 
+    TRACE_END(trc_amp_write);
+    txDeadline = (txDeadline && (int32_t)(txDeadline - writeStart) > 0 ? txDeadline : writeStart) + blockUs;
   }
-  displayAudioLed(sampleBuffer[0]);
+#if INCLUDE_RTSP
+  if (rtspAudio) rtspWrite(sampleBuffer, bytesRead / sampleWidth);
+#endif
+  spectrumUpdate(sampleBuffer, bytesRead / sampleWidth);
+  meterUpdate(sampleBuffer, bytesRead / sampleWidth);
+  streamWrite(sampleBuffer, bytesRead / sampleWidth);
+  checkAudioStats();
 }
 
 static void passThru() {
@@ -264,25 +352,180 @@ static void playRecording() {
   } else LOG_WRN("PSRAM needed to record and play");
 }
 
+// WAV file imported as recording, caller holds audioSemaphore for duration
+static WavConverter* importConv = NULL;
+static bool importFull = false;
+
+bool importBegin() {
+  // replace recording with converted content of WAV file supplied by importWrite()
+  if (!psramFound() || recAudioBuffer == NULL) {
+    LOG_WRN("PSRAM needed to import");
+    return false;
+  }
+  delete importConv;
+  importConv = new WavConverter();
+  importConv->begin(SAMPLE_RATE);
+  recAudioBytes = WAV_HDR_LEN; // leave space for wave header
+  totalSamples = 0;
+  importFull = false;
+  return true;
+}
+
+bool importWrite(const uint8_t* data, size_t len) {
+  // convert next chunk of file directly into recording buffer, false when no more wanted
+  if (importConv == NULL) return false;
+  size_t inPos = 0;
+  while (inPos < len && !importConv->finished() && !importConv->error()) {
+    size_t used;
+    size_t numSamples = importConv->convert(data + inPos, len - inPos, &used, 
+      (int16_t*)(recAudioBuffer + recAudioBytes), (psramMax - recAudioBytes) / sampleWidth);
+    inPos += used;
+    recAudioBytes += numSamples * sampleWidth;
+    if (!used && !numSamples) {
+      importFull = true; // psram full
+      break;
+    }
+  }
+  return !importFull && !importConv->finished() && !importConv->error();
+}
+
+const char* importEnd() {
+  // complete import, returns NULL if recording available, else reason
+  if (importConv == NULL) return "Import not started";
+  const char* errMsg = importConv->error();
+  if (errMsg == NULL && recAudioBytes <= WAV_HDR_LEN) errMsg = "No WAV audio data";
+  if (errMsg == NULL) {
+    totalSamples = (recAudioBytes - WAV_HDR_LEN) / sampleWidth;
+    LOG_INF("Imported %d samples (%0.1f secs) from %luHz %u channel %u bit WAV%s", totalSamples, (float)totalSamples / SAMPLE_RATE,
+      importConv->inputRate(), importConv->inputChannels(), importConv->inputBits(), importFull ? ", truncated as PSRAM full" : "");
+  } else {
+    recAudioBytes = totalSamples = 0;
+    LOG_WRN("Import failed: %s", errMsg);
+  }
+  delete importConv;
+  importConv = NULL;
+  return errMsg;
+}
+
+// offline benchmark results
+static bool benchFromRec = false;
+static uint32_t benchSamples = 0;
+static uint64_t benchDspUs = 0;
+static uint32_t benchWallUs = 0;
+static uint32_t benchMaxBlockUs = 0;
+static uint32_t benchMinHeap = 0;
+static uint32_t benchMinPsram = 0;
+static uint32_t benchStack = 0;
+static uint32_t benchOverBudget = 0;
+static uint32_t benchHash = 0;
+static uint64_t benchSumSq = 0;
+static int16_t benchPeak = 0;
+int benchSecs = BENCH_SECS;
+
+static void makeTestSignal(uint32_t sampleNum) {
+  // 1 sec log sweep from 100Hz to 4kHz repeated, with low level noise
+  static float phase = 0;
+  static uint32_t noise = 22222;
+  if (!sampleNum) {
+    // same signal for each run
+    phase = 0;
+    noise = 22222;
+  }
+  float sweepPos = (float)(sampleNum % SAMPLE_RATE) / SAMPLE_RATE;
+  float freq = 100 * pow(40, sweepPos);
+  for (int i = 0; i < DMA_BUFF_LEN; i++) {
+    phase += 2 * PI * freq / SAMPLE_RATE;
+    if (phase > 2 * PI) phase -= 2 * PI;
+    noise = noise * 1664525 + 1013904223;
+    sampleBuffer[i] = (int16_t)(8000 * sin(phase)) + (int16_t)(noise >> 24) - 128;
+  }
+}
+
+static void runBench() {
+  // render current filter chain over recording or test signal as fast as possible
+  size_t recSamples = recAudioBuffer != NULL && recAudioBytes > WAV_HDR_LEN ? (recAudioBytes - WAV_HDR_LEN) / sampleWidth : 0;
+  benchFromRec = recSamples >= DMA_BUFF_LEN;
+  uint32_t srcSamples = benchFromRec ? recSamples : benchSecs * SAMPLE_RATE;
+  bool prevProfile = DSP_PROFILE;
+  DSP_PROFILE = true;
+  profReset();
+  benchSamples = benchMaxBlockUs = benchOverBudget = 0;
+  benchDspUs = benchSumSq = 0;
+  benchPeak = 0;
+  benchHash = 2166136261; // FNV-1a offset basis
+  uint32_t budgetUs = DMA_BUFF_LEN * 10000ULL * DSP_LOAD_WARN / SAMPLE_RATE;
+  benchMinHeap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  benchMinPsram = ESP.getFreePsram();
+  LOG_INF("Benchmark %lu samples from %s", srcSamples, benchFromRec ? "recording" : "test signal");
+  uint32_t wallStart = micros();
+  while (benchSamples < srcSamples && !stopAudio) {
+    if (benchFromRec) {
+      size_t blockSamples = std::min((size_t)DMA_BUFF_LEN, (size_t)(srcSamples - benchSamples));
+      memcpy(sampleBuffer, recAudioBuffer + WAV_HDR_LEN + benchSamples * sampleWidth, blockSamples * sampleWidth);
+      if (blockSamples < DMA_BUFF_LEN) memset(sampleBuffer + blockSamples, 0, (DMA_BUFF_LEN - blockSamples) * sampleWidth);
+    } else makeTestSignal(benchSamples);
+    uint32_t dspStart = micros();
+    applyFilters(DMA_BUFF_LEN); // final block zero padded, so output fingerprint covers whole blocks
+    uint32_t blockUs = micros() - dspStart;
+    benchDspUs += blockUs;
+    benchMaxBlockUs = std::max(benchMaxBlockUs, blockUs);
+    if (blockUs > budgetUs) benchOverBudget++;
+    // fingerprint of output, so a change to the filter code can be checked for any effect on the sound
+    for (int i = 0; i < DMA_BUFF_LEN; i++) {
+      benchHash = (benchHash ^ (uint16_t)sampleBuffer[i]) * 16777619;
+      benchSumSq += (int32_t)sampleBuffer[i] * sampleBuffer[i];
+      benchPeak = std::max(benchPeak, (int16_t)std::min(abs(sampleBuffer[i]), SHRT_MAX));
+    }
+    benchMinHeap = std::min(benchMinHeap, (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    benchMinPsram = std::min(benchMinPsram, (uint32_t)ESP.getFreePsram());
+    benchSamples += DMA_BUFF_LEN;
+    // allow idle task to run so watchdog not triggered
+    if (!(benchSamples / DMA_BUFF_LEN % 16)) delay(1);
+  }
+  benchWallUs = micros() - wallStart;
+  benchSamples = std::min(benchSamples, srcSamples);
+  benchStack = checkStackUse(audioHandle, 0);
+  DSP_PROFILE = prevProfile;
+  LOG_INF("Benchmark processed %lu samples in %llums", benchSamples, benchDspUs / 1000);
+}
+
+size_t formatBench(char* p, size_t buffLen, uint32_t httpStack) {
+  // benchmark results as json, with free stack of web server task that requested it
+  float dspSecs = benchDspUs / 1000000.0;
+  size_t len = snprintf(p, buffLen, "{\"source\":\"%s\",\"samples\":%lu,\"sampleRate\":%lu,"
+    "\"dspMs\":%0.1f,\"wallMs\":%0.1f,\"samplesPerSec\":%0.0f,\"rtFactor\":%0.2f,\"blockUs\":%0.0f,\"maxBlockUs\":%lu,"
+    "\"overBudget\":%lu,\"outHash\":\"%08lx\",\"outRmsDb\":%0.1f,\"outPeak\":%d,"
+    "\"minFreeHeap\":%lu,\"minFreePsram\":%lu,\"maxAllocHeap\":%lu,\"audioStackFree\":%lu,\"httpStackFree\":%lu,\"stages\":",
+    benchFromRec ? "recording" : "test signal", benchSamples, SAMPLE_RATE, 
+    dspSecs * 1000, benchWallUs / 1000.0, dspSecs > 0 ? benchSamples / dspSecs : 0, 
+    dspSecs > 0 ? benchSamples / dspSecs / SAMPLE_RATE : 0, DMA_BUFF_LEN * 1000000.0 / SAMPLE_RATE, benchMaxBlockUs,
+    benchOverBudget, benchHash, benchSamples ? 10 * log10((double)benchSumSq / benchSamples / (32768.0 * 32768.0) + 1e-12) : -120.0, benchPeak,
+    benchMinHeap, benchMinPsram, (uint32_t)ESP.getMaxAllocHeap(), benchStack, httpStack);
+  if (len < buffLen) len += profJson(p + len, buffLen - len);
+  if (len < buffLen) len += snprintf(p + len, buffLen - len, "}");
+  return std::min(len, buffLen - 1);
+}
+
 static void VCactions() {
   // action user request
   stopAudio = false;
   closeI2S();
   prepAudio();
   setupFilters();
+  resetAudioStats();
 
   // enum audioAction defined in appGlobals.h
   switch (THIS_ACTION) {
     case RECORD_ACTION:
       if (micRem) wsAsyncSendText("#M1");
-      if (micUse || micRem) makeRecording();
+      if (micUse || micRem || UDP_PORT) makeRecording();
     break;
     case PLAY_ACTION:
       // continues till stopped
       if (ampUse || spkrRem || rtspAudio) playRecording(); // play previous recording
     break;
     case PASS_ACTION:
-      if (ampUse || spkrRem || rtspAudio) {
+      if (ampUse || spkrRem || rtspAudio || UDP_PORT) {
         if (micRem) wsAsyncSendText("#M1");
         LOG_INF("Passthru started");
         wsBufferLen = 0;
@@ -290,10 +533,14 @@ static void VCactions() {
         LOG_INF("Passthru stopped"); 
       }
     break;
+    case BENCH_ACTION:
+      runBench();
+      xSemaphoreGive(benchSemaphore);
+    break;
     default: 
     break;
   }
-  displayAudioLed(0);
+  meterReset();
   xSemaphoreGive(audioSemaphore);
 }
 
@@ -306,8 +553,7 @@ static void VCactions() {
 void browserMicInput(uint8_t* wsMsg, size_t wsMsgLen) {
   // input from browser mic via websocket, send to esp amp
   if (micRem && !wsBufferLen) {
-    wsBufferLen = wsMsgLen;
-    memcpy(wsBuffer, wsMsg, wsMsgLen);
+    wsBufferLen = codecDecode(&wsRx, wsMsg, wsMsgLen, (int16_t*)wsBuffer, MAX_PAYLOAD_LEN / sampleWidth) * sampleWidth;
     int8_t adjVol = ampVol * 2; // use web page setting
     if (adjVol) {
       // increase or reduce volume, 6 is unity eg midpoint of web slider
@@ -319,7 +565,9 @@ void browserMicInput(uint8_t* wsMsg, size_t wsMsgLen) {
         wsPtr[i] = adjVol < 0 ? wsPtr[i] / abs(adjVol) : constrain((int32_t)wsPtr[i] * adjVol, SHRT_MIN, SHRT_MAX);
       }
     }
+    TRACE_BEGIN(trc_amp_write);
     I2Sstd.write(wsBuffer, wsBufferLen);
+    TRACE_END(trc_amp_write);
     wsBufferLen = 0;
   }
 }    
@@ -360,7 +608,7 @@ static void camActions() {
   // apply esp mic input to required outputs
   while (true) {
     size_t bytesRead = 0;
-    if (micRecording || !audioBytes || spkrRem) bytesRead = espMicInput(); // load sampleBuffer
+    if (micRecording || !audioBytes || spkrRem || rtspAudio) bytesRead = espMicInput(); // load sampleBuffer
     if (bytesRead) {
       if (micRecording) {
         // record mic input to SD
@@ -372,8 +620,11 @@ static void camActions() {
         memcpy(audioBuffer, sampleBuffer, bytesRead);
         audioBytes = bytesRead;
       }
+#if INCLUDE_RTSP
+      if (rtspAudio) rtspWrite(sampleBuffer, bytesRead / sampleWidth);
+#endif
       // intercom esp mic to browser speaker
-      if (spkrRem) wsAsyncSendBinary((uint8_t*)sampleBuffer, bytesRead);
+      if (spkrRem) wsAsyncSendBinary(wsCodecBuff, codecEncode(&wsTx, WS_CODEC, sampleBuffer, bytesRead / sampleWidth, wsCodecBuff), true);
     } else delay(20);
   }
 }
@@ -457,6 +708,7 @@ void prepAudio() {
 
   if (sampleBuffer == NULL) sampleBuffer = (int16_t*)malloc(sampleBytes);
   if (wsBuffer == NULL) wsBuffer = (uint8_t*)malloc(MAX_PAYLOAD_LEN);
+  if (wsCodecBuff == NULL) wsCodecBuff = (uint8_t*)malloc(WS_FRAME_LEN);
   if (audioBuffer == NULL && psramFound()) audioBuffer = (uint8_t*)ps_malloc(sampleBytes);
 #ifdef ISVC
   if (recAudioBuffer == NULL && psramFound()) recAudioBuffer = (uint8_t*)ps_malloc(psramMax + (sizeof(int16_t) * DMA_BUFF_LEN));
@@ -996,6 +996,129 @@
       const sendSize = 320; // Size of int16 buffer to send (20ms)
       const TIMEOUT_DURATION = 1000; // 1 seconds, adjust as needed
 
+      // browser mic and speaker audio sent as frames with header, see AudioCodec.h
+      const CODEC_TAG = 0x41; // 'A'
+      const CODEC_HDR_LEN = 10;
+      const ADPCM_STATE_LEN = 4;
+      const imaStep = [
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 
+        253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 
+        1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 
+        3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 
+        12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+      ];
+      const imaIndex = [-1, -1, -1, -1, 2, 4, 6, 8];
+      let wsCodec = 0; // browser mic codec, 0: PCM, 1: mu-law, 2: IMA ADPCM
+      let codecTx = { seq: 0, timestamp: 0, predictor: 0, stepIndex: 0 };
+
+      function codecFrameLen(codec, numSamples) {
+        if (codec == 1) return CODEC_HDR_LEN + numSamples;
+        if (codec == 2) return CODEC_HDR_LEN + ADPCM_STATE_LEN + Math.ceil(numSamples / 2);
+        return CODEC_HDR_LEN + numSamples * 2;
+      }
+
+      function ulawEncode(sample) {
+        const sign = sample < 0 ? 0x80 : 0;
+        const val = Math.min(Math.abs(sample), 32635) + 0x84;
+        let exponent = 7;
+        for (let mask = 0x4000; !(val & mask) && exponent > 0; exponent--, mask >>= 1);
+        return ~(sign | (exponent << 4) | ((val >> (exponent + 3)) & 0x0F)) & 0xFF;
+      }
+
+      function ulawDecode(ulaw) {
+        ulaw = ~ulaw & 0xFF;
+        const exponent = (ulaw >> 4) & 0x07;
+        const val = ((((ulaw & 0x0F) << 3) + 0x84) << exponent) - 0x84;
+        return ulaw & 0x80 ? -val : val;
+      }
+
+      function adpcmStep(st, nibble) {
+        // update ADPCM predictor from 4 bit code, same as encoder on app
+        const step = imaStep[st.stepIndex];
+        let delta = step >> 3;
+        if (nibble & 4) delta += step;
+        if (nibble & 2) delta += step >> 1;
+        if (nibble & 1) delta += step >> 2;
+        st.predictor = Math.max(-32768, Math.min(32767, st.predictor + (nibble & 8 ? -delta : delta)));
+        st.stepIndex = Math.max(0, Math.min(88, st.stepIndex + imaIndex[nibble & 7]));
+        return st.predictor;
+      }
+
+      function adpcmEncode(st, sample) {
+        let step = imaStep[st.stepIndex];
+        let diff = sample - st.predictor;
+        let nibble = 0;
+        if (diff < 0) { nibble = 8; diff = -diff; }
+        if (diff >= step) { nibble |= 4; diff -= step; }
+        step >>= 1;
+        if (diff >= step) { nibble |= 2; diff -= step; }
+        step >>= 1;
+        if (diff >= step) nibble |= 1;
+        adpcmStep(st, nibble);
+        return nibble;
+      }
+
+      function encodeFrame(samples) {
+        // encode Int16Array of mic samples using current codec
+        const codec = wsCodec;
+        const numSamples = samples.length;
+        const frame = new ArrayBuffer(codecFrameLen(codec, numSamples));
+        const view = new DataView(frame);
+        view.setUint8(0, CODEC_TAG);
+        view.setUint8(1, codec);
+        view.setUint16(2, codecTx.seq, true);
+        view.setUint32(4, codecTx.timestamp, true);
+        view.setUint16(8, numSamples, true);
+        codecTx.seq = (codecTx.seq + 1) & 0xFFFF;
+        codecTx.timestamp = (codecTx.timestamp + numSamples) >>> 0;
+        const out = new Uint8Array(frame, CODEC_HDR_LEN);
+        if (codec == 1) for (let i = 0; i < numSamples; i++) out[i] = ulawEncode(samples[i]);
+        else if (codec == 2) {
+          view.setInt16(CODEC_HDR_LEN, codecTx.predictor, true);
+          out[2] = codecTx.stepIndex;
+          for (let i = 0; i < numSamples; i += 2) {
+            const lo = adpcmEncode(codecTx, samples[i]);
+            const hi = i + 1 < numSamples ? adpcmEncode(codecTx, samples[i + 1]) : 0;
+            out[ADPCM_STATE_LEN + i / 2] = lo | (hi << 4);
+          }
+        } else new Int16Array(frame, CODEC_HDR_LEN).set(samples);
+        return frame;
+      }
+
+      function decodeFrames(buffer) {
+        // decode one or more concatenated frames from app into Int16Array
+        const view = new DataView(buffer);
+        const frames = [];
+        let pos = 0;
+        let total = 0;
+        while (pos + CODEC_HDR_LEN <= buffer.byteLength && view.getUint8(pos) == CODEC_TAG) {
+          const codec = view.getUint8(pos + 1);
+          const numSamples = view.getUint16(pos + 8, true);
+          const frameLen = codecFrameLen(codec, numSamples);
+          if (codec > 2 || pos + frameLen > buffer.byteLength) break;
+          const data = new Uint8Array(buffer, pos + CODEC_HDR_LEN, frameLen - CODEC_HDR_LEN);
+          let samples = new Int16Array(numSamples);
+          if (codec == 1) for (let i = 0; i < numSamples; i++) samples[i] = ulawDecode(data[i]);
+          else if (codec == 2) {
+            // each frame carries its own starting ADPCM state
+            const st = { predictor: view.getInt16(pos + CODEC_HDR_LEN, true), stepIndex: Math.min(data[2], 88) };
+            for (let i = 0; i < numSamples; i++) {
+              const code = data[ADPCM_STATE_LEN + (i >> 1)];
+              samples[i] = adpcmStep(st, i & 1 ? code >> 4 : code & 0x0F);
+            }
+          } else samples = new Int16Array(data.slice().buffer); // copy as frame may be unaligned
+          frames.push(samples);
+          total += numSamples;
+          pos += frameLen;
+        }
+        if (frames.length == 1) return frames[0];
+        const allSamples = new Int16Array(total);
+        pos = 0;
+        frames.forEach(f => { allSamples.set(f, pos); pos += f.length; });
+        return allSamples;
+      }
+
       function createMicAudioWorkletScript(sampleRateRatio) {
         return `
           class Resample extends AudioWorkletProcessor {
@@ -1047,6 +1170,7 @@
         // start browser mic
         const sampleRateRatio = inSampleRate / outSampleRate;
         const audioWorkletScript = createMicAudioWorkletScript(sampleRateRatio);
+        codecTx = { seq: 0, timestamp: 0, predictor: 0, stepIndex: 0 };
         try {
           if (!audioContextMic || audioContextMic.state === 'closed') audioContextMic = new AudioContext({ sampleRate: inSampleRate });
           if (!audioContextSpkr.audioWorklet) alert('Mic: AudioWorklet not supported in this browser/environment');
@@ -1067,7 +1191,7 @@
                 const bufferToSend = new Int16Array(audioBuffer.splice(0, sendSize));
                 // send audio, but drop if cant send else lag will occur
                 if (wsSkt[index] && wsSkt[index].readyState === WebSocket.OPEN) {
-                  wsSkt[index].send(bufferToSend);
+                  wsSkt[index].send(encodeFrame(bufferToSend));
                   // display average microphone signal level
                   const sum = bufferToSend.reduce((accumulator, currentValue) => accumulator + Math.abs(currentValue), 0);
                   showMicLevel(sum / bufferToSend.length / 0x1000);
@@ -1158,16 +1282,18 @@
           pcmNode = new AudioWorkletNode(audioContextSpkr, 'pcmProcessor');
           pcmNode.connect(audioContextSpkr.destination);
           initWebSocket(index);
+          sendWsMsg("+audio", index); // subscribe to audio output
         }
       }
 
       async function outputSpkr(audioData) {
-        // Output incoming PCM data from websocket to browser audio output
-        if (pcmNode) pcmNode.port.postMessage(audioData);
+        // Output incoming audio frames from websocket to browser audio output
+        if (pcmNode) pcmNode.port.postMessage(decodeFrames(audioData));
       }
 
       function closeSpkr(index) {
         // close down browser speaker
+        if (wsSkt[index] != null && wsSkt[index].readyState === WebSocket.OPEN) wsSkt[index].send("-audio");
         if (pcmNode) {
           pcmNode.disconnect();
           pcmNode = null;
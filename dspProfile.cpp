@@ -0,0 +1,233 @@
+//
+// dspProfile.cpp
+//
+// Collects cycle counts per processing stage over a window of recent blocks,
+// reported as min / avg / p99 / max in us, via the status json and optionally
+// as a periodic websocket status message.
+//
+// Also records a trace of timestamped events from DSP stages and other activity
+// in a ring buffer over a given period, which is downloaded as Chrome trace json
+// for viewing in https://ui.perfetto.dev or chrome://tracing
+//
+// s60sc 2026
+
+#include <algorithm>
+#include <atomic>
+#include "dspProfile.h"
+
+bool DSP_PROFILE = false; // collect per stage timings
+int PROF_WS_SECS = 0; // interval for websocket profile message, 0 for none
+
+static const char* stageNames[PROF_STAGES] = {"biquad", "ringmod", "vocoder", "delay", "reverb", "stft", "output", "block"};
+static uint32_t (*profCycles)[PROF_WINDOW] = NULL; // ring of recent cycle counts per stage
+static uint32_t profCount[PROF_STAGES];
+static uint32_t traceCpuMhz = 240;
+static TaskHandle_t profHandle = NULL;
+
+void profRecord(int stage, uint32_t cycles) {
+  // called from audio task, so no locking, stats may be one sample out
+  if (DSP_PROFILE && profCycles != NULL) profCycles[stage][profCount[stage]++ % PROF_WINDOW] = cycles;
+  if (traceOn) traceRecord(stage, 'X', cycles / traceCpuMhz);
+}
+
+void profReset() {
+  // clear stats when filter chain changed, buffer retained once allocated
+  if (profCycles == NULL) {
+    profCycles = (uint32_t (*)[PROF_WINDOW])calloc(PROF_STAGES * PROF_WINDOW, sizeof(uint32_t));
+    if (profCycles == NULL) {
+      LOG_WRN("Insufficient memory for DSP profiling");
+      DSP_PROFILE = false;
+    }
+  }
+  memset(profCount, 0, sizeof(profCount));
+}
+
+static bool profStats(int stage, float* stats) {
+  // calculate min, avg, p99, max in us for stage, false if no data
+  uint32_t sorted[PROF_WINDOW];
+  size_t cnt = std::min(profCount[stage], (uint32_t)PROF_WINDOW);
+  if (profCycles == NULL || !cnt) return false;
+  float cyclesPerUs = getCpuFrequencyMhz();
+  memcpy(sorted, profCycles[stage], cnt * sizeof(uint32_t));
+  std::sort(sorted, sorted + cnt);
+  uint64_t sum = 0;
+  for (size_t i = 0; i < cnt; i++) sum += sorted[i];
+  stats[0] = sorted[0] / cyclesPerUs;
+  stats[1] = sum / cnt / cyclesPerUs;
+  stats[2] = sorted[cnt * 99 / 100] / cyclesPerUs;
+  stats[3] = sorted[cnt - 1] / cyclesPerUs;
+  return true;
+}
+
+size_t profFormat(char* buff, size_t buffLen) {
+  // format stats for each active stage as html text, returns length
+  if (profCycles == NULL) return snprintf(buff, buffLen, "n/a");
+  size_t len = snprintf(buff, buffLen, "stage: min/avg/p99/max us");
+  float stats[4];
+  for (int s = 0; s < PROF_STAGES && len < buffLen; s++) {
+    if (profStats(s, stats)) len += snprintf(buff + len, buffLen - len, "<br>%s: %0.0f/%0.0f/%0.0f/%0.0f", 
+      stageNames[s], stats[0], stats[1], stats[2], stats[3]);
+  }
+  return std::min(len, buffLen - 1);
+}
+
+size_t profJson(char* buff, size_t buffLen) {
+  // format stats for each active stage as json object, returns length
+  size_t len = snprintf(buff, buffLen, "{");
+  float stats[4];
+  for (int s = 0; s < PROF_STAGES && len < buffLen; s++) {
+    if (profStats(s, stats)) len += snprintf(buff + len, buffLen - len, "\"%s\":{\"min\":%0.1f,\"avg\":%0.1f,\"p99\":%0.1f,\"max\":%0.1f},", 
+      stageNames[s], stats[0], stats[1], stats[2], stats[3]);
+  }
+  if (len < buffLen) {
+    if (len > 1) len--; // remove trailing comma
+    len += snprintf(buff + len, buffLen - len, "}");
+  }
+  return std::min(len, buffLen - 1);
+}
+
+static void profTask(void* arg) {
+  // periodically send profile stats to browser as status update
+  char profBuff[512];
+  char wsBuff[512 + 20];
+  while (PROF_WS_SECS > 0) {
+    delay(PROF_WS_SECS * 1000);
+    if (DSP_PROFILE) {
+      profFormat(profBuff, sizeof(profBuff));
+      snprintf(wsBuff, sizeof(wsBuff), "\"DSPprof\":\"%s\"", profBuff);
+      wsAsyncSendJson("ustatus", wsBuff);
+    }
+  }
+  profHandle = NULL;
+  vTaskDelete(NULL);
+}
+
+void startProfWs() {
+  // start periodic websocket message task if required
+  if (PROF_WS_SECS > 0 && profHandle == NULL)
+    xTaskCreate(profTask, "profTask", PROF_STACK_SIZE, NULL, PROF_PRI, &profHandle);
+}
+
+/************************ event trace *************************/
+
+#define TRACE_CHUNK 2048 // size of each chunk of json sent
+
+bool traceOn = false;
+
+struct traceEvent {
+  uint32_t ts; // start time in us
+  uint32_t dur; // duration in us for complete event
+  uint8_t id;
+  uint8_t tid; // index into task table
+  char phase; // B: begin, E: end, X: complete
+};
+
+static traceEvent* traceRing = NULL;
+static uint32_t traceMask;
+static uint32_t traceT0;
+static std::atomic<uint32_t> traceCount(0);
+static std::atomic<int> traceTaskCnt(0);
+static TaskHandle_t traceTasks[TRACE_TASKS];
+static char traceNames[TRACE_TASKS][configMAX_TASK_NAME_LEN];
+static const char* traceIdNames[TRACE_IDS - trc_mic_read] = {"micRead", "ampWrite", "wsSend", "logWrite", "statusReq", "wsRecv"};
+
+static uint8_t traceTid() {
+  // index of calling task in task table, added on first event from task
+  TaskHandle_t thisTask = xTaskGetCurrentTaskHandle();
+  int taskCnt = std::min(traceTaskCnt.load(), TRACE_TASKS);
+  for (int i = 0; i < taskCnt; i++) if (traceTasks[i] == thisTask) return i;
+  int i = traceTaskCnt.fetch_add(1);
+  if (i >= TRACE_TASKS) return TRACE_TASKS; // table full, shown as other
+  strncpy(traceNames[i], pcTaskGetName(NULL), configMAX_TASK_NAME_LEN - 1);
+  traceTasks[i] = thisTask;
+  return i;
+}
+
+void traceRecord(int id, char phase, uint32_t durUs) {
+  // add event to ring, oldest events overwritten
+  if (!traceOn || traceRing == NULL) return;
+  traceEvent* event = &traceRing[traceCount.fetch_add(1) & traceMask];
+  event->ts = (uint32_t)esp_timer_get_time() - durUs;
+  event->dur = durUs;
+  event->id = id;
+  event->tid = traceTid();
+  event->phase = phase;
+}
+
+bool traceStart() {
+  // clear trace and start recording, ring retained once allocated
+  if (traceOn) return false;
+  if (traceRing == NULL) {
+    size_t traceLen = psramFound() ? TRACE_EVENTS : TRACE_EVENTS / 8;
+    traceRing = (traceEvent*)(psramFound() ? ps_malloc(traceLen * sizeof(traceEvent)) : malloc(traceLen * sizeof(traceEvent)));
+    if (traceRing == NULL) {
+      LOG_WRN("Insufficient memory for trace");
+      return false;
+    }
+    traceMask = traceLen - 1;
+  }
+  traceCount = 0;
+  traceTaskCnt = 0;
+  memset(traceTasks, 0, sizeof(traceTasks));
+  traceCpuMhz = getCpuFrequencyMhz();
+  traceT0 = (uint32_t)esp_timer_get_time();
+  traceOn = true;
+  LOG_INF("Started trace of %u events", traceMask + 1);
+  return true;
+}
+
+void traceStop() {
+  traceOn = false;
+  delay(10); // allow any event being recorded to complete
+}
+
+static const char* traceName(int id) {
+  if (id < PROF_STAGES) return stageNames[id];
+  if (id >= trc_mic_read && id < TRACE_IDS) return traceIdNames[id - trc_mic_read];
+  return "unknown";
+}
+
+esp_err_t traceSend(httpd_req_t* req) {
+  // stream recorded events as chrome trace json
+  char* chunk = (char*)malloc(TRACE_CHUNK);
+  if (chunk == NULL) {
+    LOG_WRN("Insufficient memory to send trace");
+    return ESP_FAIL;
+  }
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"trace.json\"");
+  uint32_t eventCnt = traceCount.load();
+  uint32_t traceLen = traceMask + 1;
+  uint32_t first = eventCnt > traceLen ? eventCnt - traceLen : 0;
+  int taskCnt = std::min(traceTaskCnt.load(), TRACE_TASKS);
+
+  // metadata naming process and tasks
+  size_t len = snprintf(chunk, TRACE_CHUNK, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"events\":%lu,\"overwritten\":%lu},\"traceEvents\":[\n"
+    "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"%s\"}}", eventCnt, first, APP_NAME);
+  for (int i = 0; i <= taskCnt; i++) {
+    if (i == taskCnt && traceTaskCnt.load() <= TRACE_TASKS) break; // no other tasks
+    len += snprintf(chunk + len, TRACE_CHUNK - len, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", 
+      i, i < taskCnt ? traceNames[i] : "other");
+  }
+  esp_err_t res = httpd_resp_send_chunk(req, chunk, len);
+
+  // events in order recorded
+  len = 0;
+  for (uint32_t e = first; e < eventCnt && res == ESP_OK; e++) {
+    traceEvent* event = &traceRing[e & traceMask];
+    len += snprintf(chunk + len, TRACE_CHUNK - len, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%ld,\"pid\":1,\"tid\":%u", 
+      traceName(event->id), event->id < PROF_STAGES ? "dsp" : "io", event->phase, (int32_t)(event->ts - traceT0), event->tid);
+    if (event->phase == 'X') len += snprintf(chunk + len, TRACE_CHUNK - len, ",\"dur\":%lu", event->dur);
+    len += snprintf(chunk + len, TRACE_CHUNK - len, "}");
+    if (len > TRACE_CHUNK - 200) {
+      res = httpd_resp_send_chunk(req, chunk, len);
+      len = 0;
+    }
+  }
+  len += snprintf(chunk + len, TRACE_CHUNK - len, "\n]}\n");
+  if (res == ESP_OK) res = httpd_resp_send_chunk(req, chunk, len);
+  if (res == ESP_OK) httpd_resp_send_chunk(req, NULL, 0); // signal end of data
+  free(chunk);
+  LOG_INF("Sent trace of %lu events", eventCnt - first);
+  return res;
+}
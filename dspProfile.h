@@ -0,0 +1,56 @@
+//
+// dspProfile.h
+//
+// Per stage cycle profiling of audio processing.
+// Wrap a stage with:
+//   uint32_t startCycles = profStart();
+//   ... stage ...
+//   profEnd(prof_<stage>, startCycles);
+// When DSP_PROFILE is false, each call is a single flag test.
+// A stage started while profiling was off is not recorded.
+// When tracing, each stage is also recorded as a trace event.
+// In a host build, nanoseconds from the monotonic clock are counted in place of cycles.
+//
+// s60sc 2026
+
+#pragma once
+#include "appGlobals.h"
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#else
+#include <time.h>
+#endif
+
+#define PROF_WINDOW 128 // number of most recent blocks used for stats
+
+enum profStage {
+  prof_biquad = 0,
+  prof_ringmod,
+  prof_vocoder,
+  prof_delay,
+  prof_reverb,
+  prof_stft,
+  prof_output, // volume, clipping, dither
+  prof_block, // whole of applyFilters()
+  PROF_STAGES
+};
+
+void profRecord(int stage, uint32_t cycles);
+
+static inline uint32_t profCycles() {
+#ifdef ESP_PLATFORM
+  return esp_cpu_get_cycle_count();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#endif
+}
+
+static inline uint32_t profStart() {
+  return DSP_PROFILE || traceOn ? profCycles() : 0;
+}
+
+static inline void profEnd(int stage, uint32_t startCycles) {
+  if ((DSP_PROFILE || traceOn) && startCycles) profRecord(stage, profCycles() - startCycles);
+}
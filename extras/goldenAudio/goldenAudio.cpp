@@ -0,0 +1,527 @@
+//
+// goldenAudio.cpp
+//
+// Host regression test of the DSP code, built and run by goldenAudio.sh
+// Each test processes a WAV file from the corpus folder and compares the output
+// with the stored golden output in the golden folder:
+// - the SNR of the output relative to the golden must reach the test threshold,
+//   which allows for float differences between compilers but not changes in sound.
+//   For STFT based tests, where a small float difference can change the phase
+//   unwrapping, the SNR is of the STFT magnitudes, so phase is ignored. This is the
+//   mean of the SNR of each frame, so that changes in quiet passages, eg by noise
+//   suppression, are not masked by louder ones. The chirp is
+//   not used for these, as its fast sweep puts the phase deviation of some frames at
+//   the unwrap boundary, so that the output is only repeatable with the same compiler
+// - the processing time per sample, best of several runs, must be within the test
+//   budget, so that a slowdown is noticed before it reaches the device
+// Biquad and smbPitchShift are tested directly, and FilterChain with several effect
+// combinations, each in blocks of DMA_BUFF_LEN samples with a short final block.
+// The FilterChain output stage is also timed alone, separately for a volume ramp
+// in every block, for clipping, and for dither.
+// Inputs are read with WavConverter, so the 24 bit stereo 22.05kHz file also tests
+// format and rate conversion.
+// Options:
+//   --update     rewrite the golden files from the current code, after an intended change
+//   --corpus     regenerate the corpus files, which are synthesised deterministically
+//   --no-timing  skip the time budgets, eg on a slow or loaded machine
+//   --out <dir>  also save each test output to dir for listening
+//
+// s60sc 2026
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "FilterChain.h"
+#include "WavConvert.h"
+
+#define TEST_RUNS 5 // runs per test, fastest is timed
+#define READ_CHUNK 1000 // bytes fed to WavConverter at a time, not a multiple of frame size
+#define CMP_FFT_LEN 512 // STFT frame for magnitude comparison
+#define CMP_MAX_SNR 120 // dB, limit for identical frames in segmental SNR
+#define SNR_EXACT 999 // dB, output identical, not INFINITY as may be built with -ffast-math
+
+// globals otherwise defined by the app
+bool DSP_PROFILE = false;
+bool traceOn = false;
+bool DISABLE = false;
+uint32_t SAMPLE_RATE = 16000;
+static int16_t blockBuffer[DMA_BUFF_LEN];
+int16_t* sampleBuffer = blockBuffer;
+const size_t sampleBytes = DMA_BUFF_LEN * sizeof(int16_t);
+uint8_t* recAudioBuffer = NULL;
+size_t recAudioBytes = 0;
+
+uint32_t micros() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* fmtSize(uint64_t sizeVal) {
+  static char returnStr[20];
+  snprintf(returnStr, sizeof(returnStr), "%lu bytes", (unsigned long)sizeVal);
+  return returnStr;
+}
+
+static float volumeGain = 1.0; // app volume, changed each block by output ramp test
+static bool rampVolume = false;
+
+float getVolumeGain() { return volumeGain; }
+void profRecord(int, uint32_t) {}
+void profReset() {}
+void spectrumBins(const float*, long) {}
+void spectrumInit(long, float) {}
+void startProfWs() {}
+
+enum {test_convert, test_biquad, test_pitch, test_chain, test_output};
+
+struct goldenTest {
+  const char* name;
+  const char* input;
+  int kind;
+  void (*config)();
+  float minSnr; // dB relative to golden
+  bool spectral; // compare STFT magnitudes rather than waveforms
+  float maxNs; // ns per sample, 0 if not timed
+};
+
+/************************** corpus **************************/
+
+static uint32_t noiseSeed;
+
+static float noise() {
+  // xorshift32 uniform noise -1 .. 1
+  noiseSeed ^= noiseSeed << 13;
+  noiseSeed ^= noiseSeed >> 17;
+  noiseSeed ^= noiseSeed << 5;
+  return (int32_t)noiseSeed / 2147483648.0f;
+}
+
+static void put(std::vector<uint8_t>& buff, uint32_t val, int bytes) {
+  for (int i = 0; i < bytes; i++) buff.push_back((val >> (8 * i)) & 0xFF);
+}
+
+static bool saveFile(const std::string& path, const std::vector<uint8_t>& data) {
+  FILE* fp = fopen(path.c_str(), "wb");
+  bool ok = fp != NULL && fwrite(data.data(), 1, data.size(), fp) == data.size();
+  if (fp != NULL) fclose(fp);
+  if (!ok) printf("Failed to write %s\n", path.c_str());
+  return ok;
+}
+
+static bool loadFile(const std::string& path, std::vector<uint8_t>& data) {
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (fp == NULL) return false;
+  uint8_t chunk[4096];
+  size_t got;
+  data.clear();
+  while ((got = fread(chunk, 1, sizeof(chunk), fp)) > 0) data.insert(data.end(), chunk, chunk + got);
+  fclose(fp);
+  return true;
+}
+
+static bool savePcmWav(const std::string& path, uint32_t rate, int channels, int bits, const std::vector<float>& frames) {
+  // PCM WAV of any channel count and bit depth, from interleaved samples -1 .. 1
+  std::vector<uint8_t> wav;
+  uint32_t dataBytes = frames.size() * bits / 8;
+  wav.insert(wav.end(), {'R', 'I', 'F', 'F'});
+  put(wav, 36 + dataBytes, 4);
+  wav.insert(wav.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+  put(wav, 16, 4);
+  put(wav, 1, 2);
+  put(wav, channels, 2);
+  put(wav, rate, 4);
+  put(wav, rate * channels * bits / 8, 4);
+  put(wav, channels * bits / 8, 2);
+  put(wav, bits, 2);
+  wav.insert(wav.end(), {'d', 'a', 't', 'a'});
+  put(wav, dataBytes, 4);
+  int32_t maxVal = (1 << (bits - 1)) - 1;
+  for (float s : frames) put(wav, (uint32_t)(int32_t)lrintf(constrain(s, -1.0f, 1.0f) * maxVal), bits / 8);
+  return saveFile(path, wav);
+}
+
+static void makeChirp(std::vector<float>& out) {
+  // 0.5 sec exponential sweep 100Hz to 7kHz at -10dBFS
+  const float secs = 0.5, f0 = 100, f1 = 7000;
+  size_t len = secs * 16000;
+  float k = log(f1 / f0) / secs;
+  for (size_t i = 0; i < len; i++) {
+    float t = (float)i / 16000;
+    out.push_back(0.3 * sin(2 * M_PI * f0 * (exp(k * t) - 1) / k));
+  }
+}
+
+static void makeVowel(std::vector<float>& out) {
+  // 1.2 secs of background noise at -40dBFS, with a synthetic /a/ vowel from 0.4 to 1.0 sec
+  // pulse train gliding from 110 to 140Hz through three formant resonators
+  const float formants[3][2] = {{700, 80}, {1220, 90}, {2600, 120}}; // Hz, bandwidth
+  float res[3][4] = {}; // coefs b1, b2 and state y1, y2
+  for (int f = 0; f < 3; f++) {
+    float r = exp(-M_PI * formants[f][1] / 16000);
+    res[f][0] = 2 * r * cos(2 * M_PI * formants[f][0] / 16000);
+    res[f][1] = -r * r;
+  }
+  float phase = 0, peak = 0;
+  size_t len = 1.2 * 16000;
+  std::vector<float> voice(len);
+  for (size_t i = 0; i < len; i++) {
+    float t = (float)i / 16000;
+    if (t >= 0.4 && t < 1.0) {
+      float f0 = 110 + 30 * (t - 0.4) / 0.6;
+      phase += f0 / 16000;
+      float pulse = 0;
+      if (phase >= 1) {
+        phase -= 1;
+        pulse = 1;
+      }
+      // cascade of resonators, with 20ms fade in and out
+      for (int f = 0; f < 3; f++) {
+        float y = pulse + res[f][0] * res[f][2] + res[f][1] * res[f][3];
+        res[f][3] = res[f][2];
+        res[f][2] = y;
+        pulse = y;
+      }
+      float env = std::min(1.0f, std::min(t - 0.4f, 1.0f - t) / 0.02f);
+      voice[i] = env * pulse;
+      peak = std::max(peak, fabsf(voice[i]));
+    }
+  }
+  // vowel peak at -6dBFS
+  noiseSeed = 12345;
+  for (size_t i = 0; i < len; i++) out.push_back(0.5 * voice[i] / peak + 0.01 * noise());
+}
+
+static void makeStereo(std::vector<float>& out) {
+  // 0.3 secs at 22.05kHz, 440Hz left, 1kHz plus 9kHz right, so downsampling must remove 9kHz
+  size_t len = 0.3 * 22050;
+  for (size_t i = 0; i < len; i++) {
+    float t = (float)i / 22050;
+    out.push_back(0.6 * sin(2 * M_PI * 440 * t));
+    out.push_back(0.4 * sin(2 * M_PI * 1000 * t) + 0.2 * sin(2 * M_PI * 9000 * t));
+  }
+}
+
+static void makeQuiet(std::vector<float>& out) {
+  // 0.25 sec 1kHz at 3 LSB, so that dither is a large part of the output
+  size_t len = 0.25 * 16000;
+  for (size_t i = 0; i < len; i++) out.push_back(3.0 / SHRT_MAX * sin(2 * M_PI * 1000 * i / 16000));
+}
+
+static bool makeCorpus(const std::string& dir) {
+  std::vector<float> chirp, vowel, stereo, quiet;
+  makeChirp(chirp);
+  makeVowel(vowel);
+  makeStereo(stereo);
+  makeQuiet(quiet);
+  return savePcmWav(dir + "/corpus/chirp.wav", 16000, 1, 16, chirp)
+    && savePcmWav(dir + "/corpus/vowel.wav", 16000, 1, 16, vowel)
+    && savePcmWav(dir + "/corpus/stereo24.wav", 22050, 2, 24, stereo)
+    && savePcmWav(dir + "/corpus/quiet.wav", 16000, 1, 16, quiet);
+}
+
+static bool loadWav(const std::string& path, std::vector<int16_t>& samples) {
+  // any supported WAV file as mono 16 bit at SAMPLE_RATE, via WavConverter
+  std::vector<uint8_t> wav;
+  if (!loadFile(path, wav)) {
+    printf("Cannot read %s\n", path.c_str());
+    return false;
+  }
+  WavConverter conv;
+  conv.begin(SAMPLE_RATE);
+  int16_t out[DMA_BUFF_LEN];
+  size_t pos = 0;
+  samples.clear();
+  while (pos < wav.size() && !conv.finished() && conv.error() == NULL) {
+    size_t used;
+    size_t got = conv.convert(wav.data() + pos, std::min((size_t)READ_CHUNK, wav.size() - pos), &used, out, DMA_BUFF_LEN);
+    samples.insert(samples.end(), out, out + got);
+    pos += used;
+  }
+  if (conv.error() != NULL) printf("Cannot convert %s: %s\n", path.c_str(), conv.error());
+  return conv.error() == NULL && samples.size();
+}
+
+static bool saveWav(const std::string& path, const std::vector<int16_t>& samples) {
+  // mono 16 bit WAV at SAMPLE_RATE
+  std::vector<uint8_t> wav(WAV_HDR_LEN);
+  makeWavHeader(wav.data(), SAMPLE_RATE, samples.size() * sizeof(int16_t));
+  const uint8_t* data = (const uint8_t*)samples.data();
+  wav.insert(wav.end(), data, data + samples.size() * sizeof(int16_t));
+  return saveFile(path, wav);
+}
+
+/************************** tests **************************/
+
+static void resetParams() {
+  // all effects off, with moderate settings for each
+  RING_MOD = BAND_PASS = HIGH_PASS = LOW_PASS = HIGH_SHELF = LOW_SHELF = PEAK = false;
+  CLIPPING = REVERB = DELAY_LINE = NOISE_SUPP = VOCODER = DITHER = DISABLE = false;
+  BP_Q = 0.707; BP_FREQ = 1000; BP_CAS = 1;
+  HP_Q = 0.707; HP_FREQ = 200; HP_CAS = 1;
+  LP_Q = 0.707; LP_FREQ = 3000; LP_CAS = 1;
+  HS_GAIN = 0; HS_FREQ = 3000;
+  LS_GAIN = 0; LS_FREQ = 300;
+  PK_GAIN = 0; PK_FREQ = 1000; PK_Q = 0.707;
+  SW_FREQ = 30; SW_AMP = 100;
+  CLIP_FACTOR = 5; DECAY_FACTOR = 5;
+  PITCH_SHIFT = 1.0;
+  DELAY_TYPE = dl_preset_chorus; DELAY_MIX = 5;
+  RV_TYPE = 0; RV_SIZE = 5; RV_DAMP = 5;
+  NS_LEVEL = 5;
+  VOC_BANDS = 16; VOC_CARRIER = 0; VOC_FREQ = 110;
+  volumeGain = 1.0; rampVolume = false;
+}
+
+static void cfgNone() {}
+
+static void cfgVoice() {
+  // phone voice: band limited, presence peak, ring modulated and clipped
+  HIGH_PASS = LOW_PASS = PEAK = RING_MOD = CLIPPING = true;
+  HP_FREQ = 300; HP_CAS = 2;
+  LP_FREQ = 3400; LP_CAS = 4;
+  PK_FREQ = 2000; PK_GAIN = 6; PK_Q = 1.5;
+  SW_FREQ = 50;
+  CLIP_FACTOR = 7;
+}
+
+static void cfgPitchNs() {
+  PITCH_SHIFT = 1.25;
+  NOISE_SUPP = true;
+  NS_LEVEL = 8;
+}
+
+static void cfgDelayFdnVocoder() {
+  DELAY_LINE = REVERB = VOCODER = true;
+  DELAY_TYPE = dl_preset_echo; DELAY_MIX = 4;
+  RV_TYPE = 1; RV_SIZE = 6; RV_DAMP = 4; DECAY_FACTOR = 3;
+  VOC_BANDS = 12; VOC_CARRIER = 0; VOC_FREQ = 130;
+}
+
+static void cfgCombDither() {
+  REVERB = DITHER = BAND_PASS = true;
+  RV_TYPE = 0; DECAY_FACTOR = 2;
+  BP_FREQ = 1500; BP_Q = 0.9; BP_CAS = 1;
+}
+
+static void cfgNoiseVocoder() {
+  VOCODER = LOW_SHELF = HIGH_SHELF = true;
+  VOC_BANDS = 20; VOC_CARRIER = 1;
+  LS_GAIN = -6; HS_GAIN = 4;
+}
+
+static void cfgDither() { DITHER = true; }
+
+static void cfgPitchUp() { PITCH_SHIFT = 1.5; }
+static void cfgPitchDown() { PITCH_SHIFT = 0.75; }
+static void cfgPitchHalf() { PITCH_SHIFT = 0.5; }
+static void cfgPitchDouble() { PITCH_SHIFT = 2.0; }
+
+static void cfgBandPassCascade() {
+  BAND_PASS = true;
+  BP_FREQ = 800; BP_CAS = 4;
+}
+
+static void cfgChorus() {
+  DELAY_LINE = true;
+  DELAY_TYPE = dl_preset_chorus; DELAY_MIX = 6;
+}
+
+static void cfgFlanger() {
+  DELAY_LINE = true;
+  DELAY_TYPE = dl_preset_flanger; DELAY_MIX = 5;
+}
+
+static void cfgOutRamp() { rampVolume = true; }
+static void cfgOutClip() { CLIPPING = true; CLIP_FACTOR = 7; }
+
+// time budgets are about 4 times the time taken on a typical x86 PC
+static const goldenTest goldenTests[] = {
+  {"convert_stereo24", "stereo24.wav", test_convert, cfgNone, 80, false, 0},
+  {"biquad_chirp", "chirp.wav", test_biquad, cfgNone, 80, false, 100},
+  {"pitch_up_vowel", "vowel.wav", test_pitch, cfgPitchUp, 50, true, 1800},
+  {"pitch_down_vowel", "vowel.wav", test_pitch, cfgPitchDown, 50, true, 1800},
+  {"pitch_down_stereo24", "stereo24.wav", test_pitch, cfgPitchDown, 50, true, 1800},
+  {"pitch_half_vowel", "vowel.wav", test_pitch, cfgPitchHalf, 50, true, 1800},
+  {"pitch_double_vowel", "vowel.wav", test_pitch, cfgPitchDouble, 50, true, 1800},
+  {"chain_voice_vowel", "vowel.wav", test_chain, cfgVoice, 60, false, 200},
+  {"chain_voice_stereo24", "stereo24.wav", test_chain, cfgVoice, 60, false, 200},
+  {"chain_pitch_ns_vowel", "vowel.wav", test_chain, cfgPitchNs, 50, true, 1800},
+  {"chain_delay_fdn_vocoder_vowel", "vowel.wav", test_chain, cfgDelayFdnVocoder, 60, false, 1200},
+  {"chain_noise_vocoder_chirp", "chirp.wav", test_chain, cfgNoiseVocoder, 60, false, 1200},
+  {"chain_comb_dither_chirp", "chirp.wav", test_chain, cfgCombDither, 60, false, 100},
+  {"chain_dither_quiet", "quiet.wav", test_chain, cfgDither, 30, false, 100},
+  {"chain_bp_cascade_chirp", "chirp.wav", test_chain, cfgBandPassCascade, 60, false, 100},
+  {"chain_chorus_vowel", "vowel.wav", test_chain, cfgChorus, 60, false, 80},
+  {"chain_flanger_chirp", "chirp.wav", test_chain, cfgFlanger, 60, false, 80},
+  {"output_ramp_chirp", "chirp.wav", test_output, cfgOutRamp, 60, false, 40},
+  {"output_clip_chirp", "chirp.wav", test_output, cfgOutClip, 60, false, 50},
+  {"output_dither_quiet", "quiet.wav", test_output, cfgDither, 30, false, 50},
+};
+
+class OutputStageTest : public FilterChain {
+  // live chain, so volume applies, with output stage exposed
+public:
+  OutputStageTest() : FilterChain(true) {}
+  using FilterChain::outputStage;
+};
+
+static void runBiquads(std::vector<int16_t>& samples) {
+  // highpass, peak and lowpass in series, as float with no int16 rounding between
+  Biquad hp(bq_type_highpass, 300.0 / SAMPLE_RATE, 0.707, 0);
+  Biquad pk(bq_type_peak, 1500.0 / SAMPLE_RATE, 1.0, 6);
+  Biquad lp(bq_type_lowpass, 3000.0 / SAMPLE_RATE, 0.707, 0);
+  for (auto& s : samples) s = (int16_t)constrain(lrintf(lp.process(pk.process(hp.process(s)))), SHRT_MIN, SHRT_MAX);
+}
+
+static void runPitch(std::vector<int16_t>& samples) {
+  smbState st;
+  memset(&st, 0, sizeof(st));
+  smbPitchShiftInit(&st, PITCH_SHIFT, DMA_BUFF_LEN, OSAMP, SAMPLE_RATE);
+  for (size_t pos = 0; pos < samples.size(); pos += DMA_BUFF_LEN) {
+    size_t len = std::min((size_t)DMA_BUFF_LEN, samples.size() - pos);
+    smbPitchShift(&st, len, samples.data() + pos, samples.data() + pos);
+  }
+  smbPitchShiftFree(&st);
+}
+
+static void runChain(std::vector<int16_t>& samples, uint64_t* procNs) {
+  // setup not included in time
+  FilterChain* chain = new FilterChain();
+  chain->setup(SAMPLE_RATE);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t pos = 0; pos < samples.size(); pos += DMA_BUFF_LEN)
+    chain->process(samples.data() + pos, std::min((size_t)DMA_BUFF_LEN, samples.size() - pos));
+  *procNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  delete chain;
+}
+
+static void runOutputStage(std::vector<int16_t>& samples, uint64_t* procNs) {
+  // output stage alone, if ramping volume it alternates between 4, so the chirp saturates, and 0.5 each block
+  volumeGain = 1.0;
+  OutputStageTest* chain = new OutputStageTest();
+  chain->setup(SAMPLE_RATE);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t pos = 0; pos < samples.size(); pos += DMA_BUFF_LEN) {
+    if (rampVolume) volumeGain = (pos / DMA_BUFF_LEN) & 1 ? 0.5 : 4.0;
+    chain->outputStage(samples.data() + pos, std::min((size_t)DMA_BUFF_LEN, samples.size() - pos));
+  }
+  *procNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  delete chain;
+}
+
+static void frameMagnitudes(const int16_t* samples, float* mags) {
+  // hann windowed frame magnitudes, using app FFT
+  float fftBuff[2 * CMP_FFT_LEN];
+  for (int i = 0; i < CMP_FFT_LEN; i++) {
+    fftBuff[2 * i] = samples[i] * (0.5 - 0.5 * cos(2 * M_PI * i / CMP_FFT_LEN));
+    fftBuff[2 * i + 1] = 0;
+  }
+  smbFft(fftBuff, CMP_FFT_LEN, -1);
+  for (int k = 0; k <= CMP_FFT_LEN / 2; k++) mags[k] = hypotf(fftBuff[2 * k], fftBuff[2 * k + 1]);
+}
+
+template <typename T>
+static float snrDb(const std::vector<T>& ref, const std::vector<T>& out) {
+  // signal to difference ratio, SNR_EXACT if identical
+  double sig = 0, diff = 0;
+  for (size_t i = 0; i < ref.size(); i++) {
+    sig += (double)ref[i] * ref[i];
+    diff += ((double)out[i] - ref[i]) * ((double)out[i] - ref[i]);
+  }
+  if (diff == 0) return SNR_EXACT;
+  return 10 * log10(std::max(sig, 1.0) / diff);
+}
+
+static float spectralSnrDb(const std::vector<int16_t>& ref, const std::vector<int16_t>& out) {
+  // mean over frames overlapped by half of SNR of STFT magnitudes
+  std::vector<float> refMags(CMP_FFT_LEN / 2 + 1), outMags(CMP_FFT_LEN / 2 + 1);
+  double sum = 0;
+  int frames = 0;
+  for (size_t pos = 0; pos + CMP_FFT_LEN <= ref.size(); pos += CMP_FFT_LEN / 2, frames++) {
+    frameMagnitudes(ref.data() + pos, refMags.data());
+    frameMagnitudes(out.data() + pos, outMags.data());
+    sum += std::min(snrDb(refMags, outMags), (float)CMP_MAX_SNR);
+  }
+  return frames ? sum / frames : snrDb(ref, out);
+}
+
+static bool runTest(const goldenTest& test, const std::string& dir, bool update, bool timing, const char* outDir) {
+  std::vector<int16_t> input, output, golden;
+  if (!loadWav(dir + "/corpus/" + test.input, input)) return false;
+  resetParams();
+  test.config();
+  uint64_t bestNs = UINT64_MAX;
+  for (int run = 0; run < TEST_RUNS; run++) {
+    std::vector<int16_t> samples = input;
+    uint64_t procNs = 0;
+    auto start = std::chrono::steady_clock::now();
+    switch (test.kind) {
+      case test_biquad: runBiquads(samples); break;
+      case test_pitch: runPitch(samples); break;
+      case test_chain: runChain(samples, &procNs); break;
+      case test_output: runOutputStage(samples, &procNs); break;
+      default: break;
+    }
+    if (test.kind != test_chain && test.kind != test_output)
+      procNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    bestNs = std::min(bestNs, procNs);
+    if (!run) output = samples;
+    else if (samples != output) {
+      printf("%-30s FAIL, output differs between runs\n", test.name);
+      return false;
+    }
+  }
+  float nsPerSample = (float)bestNs / input.size();
+  std::string goldenPath = dir + "/golden/" + test.name + ".wav";
+  if (outDir != NULL) saveWav(std::string(outDir) + "/" + test.name + ".wav", output);
+  if (update) {
+    bool ok = saveWav(goldenPath, output);
+    printf("%-30s %s, %0.1f ns/sample\n", test.name, ok ? "updated" : "FAIL", nsPerSample);
+    return ok;
+  }
+
+  std::vector<uint8_t> wav;
+  if (!loadFile(goldenPath, wav) || wav.size() < WAV_HDR_LEN) {
+    printf("%-30s FAIL, no golden file, run with --update\n", test.name);
+    return false;
+  }
+  golden.assign((int16_t*)(wav.data() + WAV_HDR_LEN), (int16_t*)(wav.data() + wav.size()));
+  if (golden.size() != output.size()) {
+    printf("%-30s FAIL, %u samples, golden has %u\n", test.name, (unsigned)output.size(), (unsigned)golden.size());
+    return false;
+  }
+  float snr = snrDb(golden, output);
+  if (test.spectral && snr < SNR_EXACT) snr = spectralSnrDb(golden, output);
+  bool snrOk = snr >= test.minSnr;
+  bool timeOk = !timing || !test.maxNs || nsPerSample <= test.maxNs;
+  char snrStr[16], timeStr[48] = "";
+  if (snr >= SNR_EXACT) strcpy(snrStr, "exact");
+  else snprintf(snrStr, sizeof(snrStr), "%0.1f dB", snr);
+  if (test.maxNs) snprintf(timeStr, sizeof(timeStr), ", %0.1f ns/sample (max %0.0f)", nsPerSample, test.maxNs);
+  printf("%-30s %s, %sSNR %s (min %0.0f)%s%s%s\n", test.name, snrOk && timeOk ? "ok" : "FAIL", test.spectral ? "spectral " : "",
+    snrStr, test.minSnr, timeStr, snrOk ? "" : ", output changed", timeOk ? "" : ", over budget");
+  return snrOk && timeOk;
+}
+
+int main(int argc, char** argv) {
+  std::string dir = ".";
+  bool update = false, corpus = false, timing = true;
+  const char* outDir = NULL;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--update") update = true;
+    else if (arg == "--corpus") corpus = true;
+    else if (arg == "--no-timing") timing = false;
+    else if (arg == "--dir" && i + 1 < argc) dir = argv[++i];
+    else if (arg == "--out" && i + 1 < argc) outDir = argv[++i];
+    else {
+      printf("Usage: %s [--dir <test folder>] [--update] [--corpus] [--no-timing] [--out <dir>]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (corpus && !makeCorpus(dir)) return 1;
+  int failures = 0;
+  for (auto& test : goldenTests) if (!runTest(test, dir, update, timing, outDir)) failures++;
+  printf("%s, %d of %d tests failed\n", failures ? "FAIL" : "PASS", failures, (int)(sizeof(goldenTests) / sizeof(goldenTests[0])));
+  return failures ? 1 : 0;
+}
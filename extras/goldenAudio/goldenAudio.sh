@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# goldenAudio.sh
+#
+# Builds the DSP code for the host and runs the golden audio tests, see goldenAudio.cpp
+# The DSP sources are copied to a temporary folder alongside the host version of
+# appGlobals.h in the host folder, so that their includes of appGlobals.h do not
+# pick up the app one. The constants it shares with the app are extracted from the
+# app headers into appDefines.h.
+# Needs g++, with optional CXXFLAGS in place of -O2. Run from any folder:
+#   sh goldenAudio.sh [--update] [--corpus] [--no-timing] [--out <dir>]
+#
+# s60sc 2026
+
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT="$HERE/../.."
+BUILD=$(mktemp -d)
+trap 'rm -rf "$BUILD"' EXIT
+
+for f in Biquad.h Biquad.cpp DelayLine.h DelayLine.cpp FDNReverb.h FDNReverb.cpp FilterChain.h Filters.cpp \
+  NoiseSuppress.cpp Vocoder.h Vocoder.cpp WavConvert.h WavConvert.cpp dspProfile.h smbPitchShift.h smbPitchShift.cpp; do
+  cp "$ROOT/$f" "$BUILD/"
+done
+cp "$HERE/host/appGlobals.h" "$BUILD/"
+# constants shared with the app taken from its headers
+DEFINES="DMA_BUFF_LEN REVERB_MS OSAMP SHAPER_LEN WAV_HDR_LEN"
+for d in $DEFINES; do
+  LINE=$(grep -h "^#define $d " "$ROOT/appGlobals.h" "$ROOT/globals.h" | tr -d '\r')
+  if [ -z "$LINE" ]; then
+    echo "$d not found in app headers"
+    exit 1
+  fi
+  echo "$LINE" >> "$BUILD/appDefines.h"
+done
+g++ ${CXXFLAGS:--O2} -std=c++17 -I"$BUILD" -o "$BUILD/goldenAudio" "$HERE/goldenAudio.cpp" "$BUILD"/*.cpp
+"$BUILD/goldenAudio" --dir "$HERE" "$@"
@@ -0,0 +1,105 @@
+//
+// appGlobals.h for host build of the DSP code by goldenAudio.sh
+//
+// Replaces the app appGlobals.h with only what the filter chain, its effects and
+// the WAV converter need, mapping ESP32 memory and timing calls to the host.
+// Constants shared with the app are in appDefines.h, which goldenAudio.sh extracts
+// from the app headers so they cannot drift. Variable types are checked by the
+// compiler, as the DSP sources define them against the declarations below.
+//
+// s60sc 2026
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <float.h>
+#include <algorithm>
+
+#include "appDefines.h" // DMA_BUFF_LEN, REVERB_MS, OSAMP, SHAPER_LEN, WAV_HDR_LEN
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// log warnings and errors only, so test output is not cluttered
+#define LOG_INF(format, ...) do {} while (0)
+#define LOG_VRB(format, ...) do {} while (0)
+#define LOG_WRN(format, ...) printf("  [WARN] " format "\n", ##__VA_ARGS__)
+#define LOG_ERR(format, ...) printf("  [ERROR] " format "\n", ##__VA_ARGS__)
+
+// no PSRAM or internal RAM distinction on host
+#define MALLOC_CAP_INTERNAL 0
+#define MALLOC_CAP_8BIT 0
+#define heap_caps_malloc(size, caps) malloc(size)
+#define heap_caps_calloc(num, size, caps) calloc(num, size)
+#define ps_malloc(size) malloc(size)
+#define ps_calloc(num, size) calloc(num, size)
+static inline bool psramFound() { return false; }
+uint32_t micros();
+const char* fmtSize(uint64_t sizeVal);
+
+// as app appGlobals.h
+void profReset();
+void spectrumBins(const float* magn, long fftFrameSize2);
+void spectrumInit(long fftFrameSize, float sampleRate);
+void startProfWs();
+float getVolumeGain();
+void smbFft(float *fftBuffer, long fftFrameSize, long sign);
+
+extern bool RING_MOD;
+extern bool BAND_PASS;
+extern bool HIGH_PASS;
+extern bool LOW_PASS;
+extern bool HIGH_SHELF;
+extern bool LOW_SHELF;
+extern bool PEAK;
+extern bool CLIPPING;
+extern bool REVERB;
+extern bool DELAY_LINE;
+extern bool NOISE_SUPP;
+extern bool VOCODER;
+extern bool DITHER;
+extern bool DSP_PROFILE;
+extern bool traceOn;
+extern float BP_Q;
+extern float BP_FREQ;
+extern uint16_t BP_CAS;
+extern float HP_Q;
+extern float HP_FREQ;
+extern uint16_t HP_CAS;
+extern float LP_Q;
+extern float LP_FREQ;
+extern uint16_t LP_CAS;
+extern float HS_GAIN;
+extern float HS_FREQ;
+extern float LS_GAIN;
+extern float LS_FREQ;
+extern float PK_GAIN;
+extern float PK_FREQ;
+extern float PK_Q;
+extern int SW_FREQ;
+extern uint8_t SW_AMP;
+extern int CLIP_FACTOR;
+extern int DECAY_FACTOR;
+extern float PITCH_SHIFT;
+extern int DELAY_TYPE;
+extern int DELAY_MIX;
+extern int RV_TYPE;
+extern int RV_SIZE;
+extern int RV_DAMP;
+extern int NS_LEVEL;
+extern int VOC_BANDS;
+extern int VOC_CARRIER;
+extern int VOC_FREQ;
+extern bool DISABLE;
+extern uint32_t SAMPLE_RATE;
+extern int16_t* sampleBuffer;
+extern const size_t sampleBytes;
+extern uint8_t* recAudioBuffer;
+extern size_t recAudioBytes;
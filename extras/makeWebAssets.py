@@ -0,0 +1,81 @@
+#
+# makeWebAssets.py
+#
+# Precompresses the web page files in the data folder for serving with
+# Content-Encoding: gzip, each with a strong ETag from a hash of its content.
+# Generates webAssets.h in the sketch folder, holding the compressed files as
+# byte arrays in flash, used when INCLUDE_WEB_ASSETS is true in appGlobals.h
+# so that the web page loads without storage reads.
+# Optionally also writes <file>.gz to the data folder, for uploading to storage
+# alongside the originals. Each .gz has the hash of its original in the gzip
+# comment field, so the app can tell if the original has since been replaced.
+# Rerun after any change to the web page files.
+#
+# Run from extras folder:
+#   python3 makeWebAssets.py [--storage] [data files ...]
+#
+# s60sc 2026
+
+import os
+import struct
+import sys
+import zlib
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+DATA_DIR = 'data'
+DEFAULT_FILES = ['VC.htm', 'common.js']
+HEADER = os.path.join(ROOT, 'webAssets.h')
+
+
+def fnv1a64(data):
+  # same hash as fileEtag() in webServer.cpp
+  h = 0xcbf29ce484222325
+  for b in data:
+    h = ((h ^ b) * 0x100000001b3) & 0xffffffffffffffff
+  return h
+
+
+def gzipWithSource(raw):
+  # gzip member with hash of original as comment, see gzCurrent() in webServer.cpp
+  # fixed mtime so output only changes when content does
+  comment = ('%016x' % fnv1a64(raw)).encode() + b'\0'
+  header = b'\x1f\x8b\x08\x10' + struct.pack('<I', 0) + b'\x02\xff' + comment
+  deflater = zlib.compressobj(9, zlib.DEFLATED, -15)
+  body = deflater.compress(raw) + deflater.flush()
+  return header + body + struct.pack('<II', zlib.crc32(raw), len(raw) & 0xffffffff)
+
+
+def main():
+  args = sys.argv[1:]
+  storage = '--storage' in args
+  names = [a for a in args if not a.startswith('--')] or DEFAULT_FILES
+  out = ['// Generated by extras/makeWebAssets.py from web page files, do not edit', '',
+    '#pragma once', '']
+  entries = []
+  for i, name in enumerate(names):
+    with open(os.path.join(ROOT, DATA_DIR, name), 'rb') as f:
+      raw = f.read()
+    gz = gzipWithSource(raw)
+    if storage:
+      with open(os.path.join(ROOT, DATA_DIR, name + '.gz'), 'wb') as f:
+        f.write(gz)
+    out.append('// /%s/%s: %u bytes, gzipped %u bytes' % (DATA_DIR, name, len(raw), len(gz)))
+    out.append('static const uint8_t webAsset%d[] = {' % i)
+    for j in range(0, len(gz), 20):
+      out.append('  ' + ','.join('0x%02x' % b for b in gz[j:j + 20]) + ',')
+    out.append('};')
+    out.append('')
+    entries.append('  {"/%s/%s", "\\"%016x\\"", webAsset%d, %u},' % (DATA_DIR, name, fnv1a64(gz), i, len(gz)))
+    print('%s: %u -> %u bytes' % (name, len(raw), len(gz)))
+  out.append('static const webAsset webAssets[] = {')
+  out.extend(entries)
+  out.append('};')
+  out.append('#define WEB_ASSET_COUNT %u' % len(entries))
+  out.append('')
+  with open(HEADER, 'w', newline='\r\n') as f:
+    f.write('\n'.join(out))
+  print('Generated %s' % os.path.normpath(HEADER))
+
+
+if __name__ == '__main__':
+  main()
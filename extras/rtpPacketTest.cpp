@@ -0,0 +1,169 @@
+//
+// rtpPacketTest.cpp
+//
+// Linux check of the RTSP audio packetiser, see RtpPacketiser.h
+// Uses the same ring size and skip margin as rtsp.cpp, and checks:
+// - packet length for each ptime and sample rate, limited to the RTP payload size
+// - packets read across the end of the ring carry the samples in order
+// - a block that does not fit in the ring is dropped whole, leaving queued audio intact
+// - while the server is not ready, packets are held until the skip margin is
+//   exceeded, then skipped one at a time, so the sender resumes in step
+// Queued samples are a running count, so each packet can be checked for its
+// expected content.
+//
+// Build:
+//   g++ -O2 -o rtpPacketTest rtpPacketTest.cpp ../RtpPacketiser.cpp
+// Run:
+//   ./rtpPacketTest
+//
+// s60sc 2026
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "../RtpPacketiser.h"
+
+// as appGlobals.h and rtsp.cpp
+#define DMA_BUFF_LEN 1024
+#define RTSP_BLOCKS 4
+#define RTSP_RING_LEN (RTSP_BLOCKS * DMA_BUFF_LEN)
+#define RTP_MAX_PAYLOAD 1400
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { failures++; printf("FAIL line %d: ", __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+struct packetTest {
+  std::vector<int16_t> ring, packetBuff, block;
+  RtpPacketiser pack;
+  uint32_t written = 0; // next sample value to write
+  uint32_t expected = 0; // next sample value expected in packet
+
+  packetTest(size_t packetLen) : ring(RTSP_RING_LEN), packetBuff(packetLen) {}
+
+  bool write(size_t numSamples) {
+    // queue block of running sample count
+    block.resize(numSamples);
+    for (size_t i = 0; i < numSamples; i++) block[i] = (int16_t)(written + i);
+    bool queued = pack.write(block.data(), numSamples);
+    if (queued) written += numSamples;
+    return queued;
+  }
+
+  bool readCheck() {
+    // read packet at tail and check it continues sequence
+    const int16_t* packet = pack.packet();
+    for (size_t i = 0; i < pack.samples(); i++) {
+      if (packet[i] != (int16_t)(expected + i)) {
+        printf("  sample %u of packet at %u is %d, expected %d\n", (unsigned)i, expected, packet[i], (int16_t)(expected + i));
+        return false;
+      }
+    }
+    pack.advance();
+    expected += pack.samples();
+    return true;
+  }
+};
+
+static void testPacketLen() {
+  // ptime constrained to 10..40ms, and payload to RTP_MAX_PAYLOAD
+  const uint32_t rates[] = {8000, 11025, 16000, 22050, 32000, 44100, 48000};
+  const int ptimes[] = {0, 5, 10, 20, 30, 40, 60};
+  for (uint32_t rate : rates) {
+    for (int ptime : ptimes) {
+      size_t len = rtpPacketLen(rate, ptime, RTP_MAX_PAYLOAD);
+      int clamped = ptime < 10 ? 10 : ptime > 40 ? 40 : ptime;
+      size_t want = rate * clamped / 1000;
+      if (want > RTP_MAX_PAYLOAD / 2) want = RTP_MAX_PAYLOAD / 2;
+      CHECK(len == want, "%uHz %dms gave %u samples, expected %u", rate, ptime, (unsigned)len, (unsigned)want);
+      CHECK(len * sizeof(int16_t) <= RTP_MAX_PAYLOAD, "%uHz %dms payload %u bytes too long", rate, ptime, (unsigned)(len * 2));
+    }
+  }
+  CHECK(rtpPacketLen(48000, 20, RTP_MAX_PAYLOAD) == 700, "48kHz 20ms not capped at 700 samples");
+}
+
+static void testInit() {
+  // reject ring not power of 2, or too small for packet plus margin
+  std::vector<int16_t> ring(RTSP_RING_LEN), packetBuff(700);
+  RtpPacketiser pack;
+  CHECK(!pack.write(ring.data(), 10), "write before init accepted");
+  CHECK(!pack.init(ring.data(), 3000, packetBuff.data(), 320, DMA_BUFF_LEN), "ring length not power of 2 accepted");
+  CHECK(!pack.init(ring.data(), 1024, packetBuff.data(), 320, DMA_BUFF_LEN), "ring without room for skip margin accepted");
+  CHECK(!pack.init(ring.data(), RTSP_RING_LEN, NULL, 320, DMA_BUFF_LEN), "missing packet buffer accepted");
+  CHECK(pack.init(ring.data(), RTSP_RING_LEN, packetBuff.data(), 320, DMA_BUFF_LEN), "valid init rejected");
+}
+
+static void testWrap(size_t packetLen, size_t blockLen) {
+  // stream many times round ring, with reader keeping up
+  packetTest t(packetLen);
+  t.pack.init(t.ring.data(), RTSP_RING_LEN, t.packetBuff.data(), packetLen, DMA_BUFF_LEN);
+  int wraps = 0;
+  while (t.written < 20 * RTSP_RING_LEN) {
+    CHECK(t.write(blockLen), "block at %u of %u dropped while reader keeping up", t.written, (unsigned)blockLen);
+    while (t.pack.ready()) {
+      if ((t.expected & (RTSP_RING_LEN - 1)) + packetLen > RTSP_RING_LEN) wraps++;
+      if (!t.readCheck()) {
+        CHECK(false, "packet %u, block %u: wrong content", (unsigned)packetLen, (unsigned)blockLen);
+        return;
+      }
+    }
+  }
+  CHECK(!(RTSP_RING_LEN % packetLen) || wraps > 0, "packet %u never wrapped ring", (unsigned)packetLen);
+  CHECK(t.pack.maxDepth <= packetLen + blockLen, "max depth %u with reader keeping up", t.pack.maxDepth);
+}
+
+static void testDrop() {
+  // block not fitting is dropped whole, without upsetting queued samples
+  packetTest t(320);
+  t.pack.init(t.ring.data(), RTSP_RING_LEN, t.packetBuff.data(), 320, DMA_BUFF_LEN);
+  for (int b = 0; b < RTSP_BLOCKS; b++) CHECK(t.write(DMA_BUFF_LEN), "block %d dropped before ring full", b);
+  CHECK(t.pack.depth() == RTSP_RING_LEN, "depth %u when full", t.pack.depth());
+  CHECK(!t.write(DMA_BUFF_LEN), "block queued when ring full");
+  CHECK(!t.write(1), "sample queued when ring full");
+  CHECK(t.readCheck(), "content changed by dropped block");
+  CHECK(!t.write(DMA_BUFF_LEN), "block queued without room");
+  CHECK(t.write(320), "block fitting freed room dropped");
+  while (t.pack.ready()) if (!t.readCheck()) { CHECK(false, "content wrong after drop"); break; }
+  CHECK(t.pack.maxDepth == RTSP_RING_LEN, "max depth %u, expected %d", t.pack.maxDepth, RTSP_RING_LEN);
+}
+
+static void testSkip(size_t packetLen) {
+  // server not ready: hold up to margin then skip oldest, then send in step when ready
+  packetTest t(packetLen);
+  t.pack.init(t.ring.data(), RTSP_RING_LEN, t.packetBuff.data(), packetLen, DMA_BUFF_LEN);
+  uint32_t skipped = 0;
+  for (int b = 0; b < 200; b++) {
+    CHECK(t.write(DMA_BUFF_LEN), "block %d dropped while skipping, depth %u", b, t.pack.depth());
+    // sender loop with server not ready
+    while (t.pack.ready()) {
+      if (!t.pack.backlogged()) break;
+      t.pack.advance();
+      t.expected += packetLen;
+      skipped++;
+    }
+    CHECK(t.pack.depth() < packetLen + DMA_BUFF_LEN, "depth %u not limited after skip", t.pack.depth());
+    if (b == 0) CHECK(!skipped, "packet skipped before margin exceeded");
+  }
+  CHECK(skipped > 0, "no packets skipped while server not ready");
+  CHECK(t.pack.maxDepth <= packetLen + 2 * DMA_BUFF_LEN, "max depth %u while skipping", t.pack.maxDepth);
+  // server ready again, packets continue from skip point
+  for (int b = 0; b < 20; b++) {
+    t.write(DMA_BUFF_LEN);
+    while (t.pack.ready()) if (!t.readCheck()) { CHECK(false, "content wrong after skip"); return; }
+  }
+}
+
+int main() {
+  testPacketLen();
+  testInit();
+  // packet sizes for 10..40ms at 8..48kHz, block sizes as DMA_BUFF_LEN or smaller
+  const size_t packetLens[] = {80, 160, 320, 441, 480, 640, 700};
+  const size_t blockLens[] = {DMA_BUFF_LEN, 512, 160, 1};
+  for (size_t packetLen : packetLens) {
+    for (size_t blockLen : blockLens) testWrap(packetLen, blockLen);
+    testSkip(packetLen);
+  }
+  testDrop();
+  printf("%s, %d failures\n", failures ? "FAIL" : "PASS", failures);
+  return failures ? 1 : 0;
+}
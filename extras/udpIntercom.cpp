@@ -0,0 +1,182 @@
+//
+// udpIntercom.cpp
+//
+// Linux reference client for the UDP intercom, see Intercom.cpp
+// Sends a WAV file to the app in real time as the remote mic input, and records the
+// processed audio returned by the app to another WAV file.
+// The WAV file must be 16 bit mono at the sample rate selected on the app, and
+// the app must have UDP port set and be running Passthru or Record.
+//
+// Build:
+//   g++ -O2 -o udpIntercom udpIntercom.cpp ../AudioCodec.cpp -lpthread
+// Run:
+//   ./udpIntercom <app_ip> <port> <in.wav> <out.wav> [pcm|ulaw|adpcm] [frame ms]
+//
+// s60sc 2026
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <atomic>
+#include <vector>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "../AudioCodec.h"
+
+#define MAX_FRAME_SAMPLES 640 // must not exceed UDP_MAX_SAMPLES in Intercom.cpp
+#define TAIL_MS 500 // silence sent after file to flush app jitter buffer and filters
+#define RX_IDLE_MS 1000 // receiver stops after this long without frames once sending done
+
+static int sock = -1;
+static std::atomic<bool> sending(true);
+static std::vector<int16_t> rxSamples;
+static codecState rxState = {};
+static uint32_t rxFrames = 0;
+
+static bool readWav(const char* path, std::vector<int16_t>& samples, uint32_t* sampleRate) {
+  // load 16 bit mono PCM samples from WAV file
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) return false;
+  uint8_t hdr[12];
+  bool ok = fread(hdr, 1, 12, f) == 12 && !memcmp(hdr, "RIFF", 4) && !memcmp(hdr + 8, "WAVE", 4);
+  bool gotFmt = false;
+  while (ok) {
+    uint8_t chunk[8];
+    if (fread(chunk, 1, 8, f) != 8) break;
+    uint32_t chunkLen;
+    memcpy(&chunkLen, chunk + 4, 4);
+    if (!memcmp(chunk, "fmt ", 4)) {
+      uint8_t fmt[16];
+      ok = chunkLen >= 16 && fread(fmt, 1, 16, f) == 16;
+      uint16_t format, channels, bits;
+      memcpy(&format, fmt, 2);
+      memcpy(&channels, fmt + 2, 2);
+      memcpy(sampleRate, fmt + 4, 4);
+      memcpy(&bits, fmt + 14, 2);
+      if (format != 1 || channels != 1 || bits != 16) {
+        fprintf(stderr, "%s must be 16 bit mono PCM\n", path);
+        ok = false;
+      }
+      fseek(f, chunkLen - 16 + (chunkLen & 1), SEEK_CUR);
+      gotFmt = true;
+    } else if (!memcmp(chunk, "data", 4) && gotFmt) {
+      samples.resize(chunkLen / sizeof(int16_t));
+      samples.resize(fread(samples.data(), sizeof(int16_t), samples.size(), f));
+      fclose(f);
+      return true;
+    } else fseek(f, chunkLen + (chunkLen & 1), SEEK_CUR);
+  }
+  fclose(f);
+  return false;
+}
+
+static bool writeWav(const char* path, const std::vector<int16_t>& samples, uint32_t sampleRate) {
+  FILE* f = fopen(path, "wb");
+  if (f == NULL) return false;
+  uint32_t dataLen = samples.size() * sizeof(int16_t);
+  uint32_t riffLen = dataLen + 36;
+  uint32_t byteRate = sampleRate * sizeof(int16_t);
+  uint32_t fmtLen = 16;
+  uint16_t format = 1, channels = 1, align = 2, bits = 16;
+  fwrite("RIFF", 1, 4, f); fwrite(&riffLen, 4, 1, f); fwrite("WAVEfmt ", 1, 8, f);
+  fwrite(&fmtLen, 4, 1, f); fwrite(&format, 2, 1, f); fwrite(&channels, 2, 1, f);
+  fwrite(&sampleRate, 4, 1, f); fwrite(&byteRate, 4, 1, f); fwrite(&align, 2, 1, f); fwrite(&bits, 2, 1, f);
+  fwrite("data", 1, 4, f); fwrite(&dataLen, 4, 1, f);
+  fwrite(samples.data(), sizeof(int16_t), samples.size(), f);
+  return fclose(f) == 0;
+}
+
+static void* rxThread(void*) {
+  // receive processed frames until idle after sending finished
+  uint8_t buff[CODEC_HDR_LEN + MAX_FRAME_SAMPLES * sizeof(int16_t) * 4];
+  int16_t samples[MAX_FRAME_SAMPLES * 4];
+  int idleMs = 0;
+  while (sending || idleMs < RX_IDLE_MS) {
+    ssize_t len = recv(sock, buff, sizeof(buff), 0);
+    if (len <= 0) {
+      idleMs += 100; // receive timeout
+      continue;
+    }
+    idleMs = 0;
+    size_t numSamples = codecDecode(&rxState, buff, len, samples, sizeof(samples) / sizeof(int16_t));
+    rxSamples.insert(rxSamples.end(), samples, samples + numSamples);
+    rxFrames++;
+  }
+  return NULL;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 5) {
+    fprintf(stderr, "Usage: %s <app_ip> <port> <in.wav> <out.wav> [pcm|ulaw|adpcm] [frame ms]\n", argv[0]);
+    return 1;
+  }
+  int codec = codec_pcm;
+  if (argc > 5 && !strcmp(argv[5], "ulaw")) codec = codec_ulaw;
+  else if (argc > 5 && !strcmp(argv[5], "adpcm")) codec = codec_adpcm;
+  int frameMs = argc > 6 ? atoi(argv[6]) : 20;
+
+  std::vector<int16_t> txSamples;
+  uint32_t sampleRate = 0;
+  if (!readWav(argv[3], txSamples, &sampleRate)) {
+    fprintf(stderr, "Unable to read %s\n", argv[3]);
+    return 1;
+  }
+  size_t frameLen = sampleRate * frameMs / 1000;
+  if (!frameLen || frameLen > MAX_FRAME_SAMPLES) {
+    fprintf(stderr, "Frame of %dms at %uHz must be 1 to %d samples\n", frameMs, sampleRate, MAX_FRAME_SAMPLES);
+    return 1;
+  }
+  txSamples.resize(txSamples.size() + sampleRate * TAIL_MS / 1000, 0);
+
+  struct sockaddr_in app = {};
+  app.sin_family = AF_INET;
+  app.sin_port = htons(atoi(argv[2]));
+  if (inet_pton(AF_INET, argv[1], &app.sin_addr) != 1) {
+    fprintf(stderr, "Invalid address %s\n", argv[1]);
+    return 1;
+  }
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  struct timeval timeout = {0, 100000};
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  if (sock < 0 || connect(sock, (struct sockaddr*)&app, sizeof(app)) < 0) {
+    perror("socket");
+    return 1;
+  }
+  printf("Sending %s, %0.1f secs at %uHz as %zu sample frames with codec %d\n", 
+    argv[3], (float)txSamples.size() / sampleRate, sampleRate, frameLen, codec);
+  pthread_t rx;
+  pthread_create(&rx, NULL, rxThread, NULL);
+
+  // send frames at real time rate
+  codecState txState = {};
+  uint8_t frame[CODEC_HDR_LEN + MAX_FRAME_SAMPLES * sizeof(int16_t)];
+  struct timespec due;
+  clock_gettime(CLOCK_MONOTONIC, &due);
+  uint32_t txFrames = 0;
+  for (size_t i = 0; i < txSamples.size(); i += frameLen) {
+    size_t len = codecEncode(&txState, codec, txSamples.data() + i, std::min(frameLen, txSamples.size() - i), frame);
+    if (send(sock, frame, len, 0) < 0) perror("send");
+    txFrames++;
+    due.tv_nsec += frameMs * 1000000L;
+    if (due.tv_nsec >= 1000000000L) {
+      due.tv_sec++;
+      due.tv_nsec -= 1000000000L;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+  }
+  sending = false;
+  pthread_join(rx, NULL);
+  close(sock);
+
+  printf("Sent %u frames, received %u frames with %u missing, %0.1f secs\n", 
+    txFrames, rxFrames, rxState.lost, (float)rxSamples.size() / sampleRate);
+  if (!writeWav(argv[4], rxSamples, sampleRate)) {
+    fprintf(stderr, "Unable to write %s\n", argv[4]);
+    return 1;
+  }
+  printf("Saved %s\n", argv[4]);
+  return 0;
+}
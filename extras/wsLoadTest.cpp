@@ -0,0 +1,229 @@
+//
+// wsLoadTest.cpp
+//
+// Linux load test of the app websocket server, see wsSendTask() in webServer.cpp
+// Connects several websocket clients, each subscribed to the speaker audio, and
+// checks that each receives audio at the sample rate without sequence gaps.
+// Some clients can be made slow readers, to check that they do not hold up the
+// others. Finally the WSqueue status is fetched to show the per client sent and
+// dropped counters kept by the app.
+// The app must be running Passthru or Play, with output enabled for browser speaker.
+//
+// Build:
+//   g++ -O2 -o wsLoadTest wsLoadTest.cpp ../AudioCodec.cpp -lpthread
+// Run:
+//   ./wsLoadTest <app_ip> [clients] [secs] [slow clients] [sample rate]
+//
+// s60sc 2026
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include "../AudioCodec.h"
+
+#define WS_PORT 80
+#define MAX_MSG (64 * 1024)
+#define MAX_SAMPLES 8192 // per websocket message, several codec frames may be merged
+#define SLOW_READ_MS 300 // pause between reads by a slow client
+#define MIN_RATE_PCT 95 // min % of sample rate received by each normal client
+#define MAX_LOST_PCT 1 // max % of audio frames missing for each normal client
+
+struct wsTestClient {
+  int id;
+  bool slow;
+  pthread_t thread;
+  codecState rx;
+  uint32_t audioMsgs, audioFrames, samples, spectrum, texts;
+  bool connected, closed;
+};
+
+static const char* appHost;
+static int testSecs = 10;
+
+static double nowSecs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int tcpConnect() {
+  struct addrinfo hints = {}, *res;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char port[8];
+  snprintf(port, sizeof(port), "%d", WS_PORT);
+  if (getaddrinfo(appHost, port, &hints, &res)) return -1;
+  int skt = socket(res->ai_family, res->ai_socktype, 0);
+  if (skt >= 0 && connect(skt, res->ai_addr, res->ai_addrlen) < 0) {
+    close(skt);
+    skt = -1;
+  }
+  freeaddrinfo(res);
+  return skt;
+}
+
+static bool readExact(int skt, uint8_t* buff, size_t len) {
+  while (len) {
+    ssize_t got = recv(skt, buff, len, 0);
+    if (got <= 0) return false;
+    buff += got;
+    len -= got;
+  }
+  return true;
+}
+
+static bool wsSend(int skt, uint8_t opcode, const char* data, size_t len) {
+  // client frames must be masked, small payloads only
+  uint8_t frame[140];
+  if (len > 125) return false;
+  uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+  frame[0] = 0x80 | opcode;
+  frame[1] = 0x80 | len;
+  memcpy(frame + 2, mask, 4);
+  for (size_t i = 0; i < len; i++) frame[6 + i] = data[i] ^ mask[i % 4];
+  return send(skt, frame, 6 + len, MSG_NOSIGNAL) == (ssize_t)(6 + len);
+}
+
+static bool wsConnect(int skt) {
+  // http upgrade, then read response header up to blank line
+  char req[256];
+  int len = snprintf(req, sizeof(req), "GET /ws HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n", appHost);
+  if (send(skt, req, len, MSG_NOSIGNAL) != len) return false;
+  std::string resp;
+  char c;
+  while (resp.find("\r\n\r\n") == std::string::npos) {
+    if (recv(skt, &c, 1, 0) != 1) return false;
+    resp += c;
+  }
+  return resp.find(" 101 ") != std::string::npos;
+}
+
+static uint32_t countFrames(const uint8_t* msg, size_t msgLen) {
+  // number of codec frames in websocket message
+  uint32_t frames = 0;
+  while (msgLen >= CODEC_HDR_LEN && msg[0] == CODEC_TAG) {
+    uint16_t numSamples;
+    memcpy(&numSamples, msg + 8, 2);
+    size_t frameLen = codecFrameLen(msg[1], numSamples);
+    if (msg[1] >= CODEC_COUNT || frameLen > msgLen) break;
+    frames++;
+    msg += frameLen;
+    msgLen -= frameLen;
+  }
+  return frames;
+}
+
+static void* clientTask(void* arg) {
+  // receive and check messages until test time ends
+  wsTestClient* client = (wsTestClient*)arg;
+  std::vector<uint8_t> msg(MAX_MSG);
+  std::vector<int16_t> samples(MAX_SAMPLES);
+  int skt = tcpConnect();
+  client->connected = skt >= 0 && wsConnect(skt) && wsSend(skt, 0x1, "+audio", 6);
+  if (!client->connected) {
+    printf("Client %d failed to connect\n", client->id);
+    if (skt >= 0) close(skt);
+    return NULL;
+  }
+  struct timeval tv = {1, 0};
+  setsockopt(skt, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  double endTime = nowSecs() + testSecs;
+  while (nowSecs() < endTime) {
+    uint8_t hdr[2];
+    if (!readExact(skt, hdr, 2)) {
+      if (nowSecs() < endTime) client->closed = true;
+      break;
+    }
+    uint8_t opcode = hdr[0] & 0x0F;
+    uint64_t len = hdr[1] & 0x7F;
+    if (len == 126) {
+      uint8_t ext[2];
+      if (!readExact(skt, ext, 2)) break;
+      len = ext[0] << 8 | ext[1];
+    } else if (len == 127) {
+      uint8_t ext[8];
+      if (!readExact(skt, ext, 8)) break;
+      len = 0;
+      for (int i = 0; i < 8; i++) len = len << 8 | ext[i];
+    }
+    if (len > MAX_MSG || !readExact(skt, msg.data(), len)) break;
+    if (opcode == 0x8) {
+      client->closed = true;
+      break;
+    } else if (opcode == 0x9) wsSend(skt, 0xA, (char*)msg.data(), len < 125 ? len : 125);
+    else if (opcode == 0x1) client->texts++;
+    else if (opcode == 0x2 && len >= 4 && !memcmp(msg.data(), "SPEC", 4)) client->spectrum++;
+    else if (opcode == 0x2 && len >= CODEC_HDR_LEN && msg[0] == CODEC_TAG) {
+      client->samples += codecDecode(&client->rx, msg.data(), len, samples.data(), MAX_SAMPLES);
+      client->audioFrames += countFrames(msg.data(), len);
+      client->audioMsgs++;
+    }
+    if (client->slow) usleep(SLOW_READ_MS * 1000);
+  }
+  wsSend(skt, 0x8, "", 0);
+  close(skt);
+  return NULL;
+}
+
+static void showQueueStats() {
+  // WSqueue field from app status json
+  int skt = tcpConnect();
+  if (skt < 0) return;
+  char req[128];
+  int len = snprintf(req, sizeof(req), "GET /status HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", appHost);
+  send(skt, req, len, MSG_NOSIGNAL);
+  std::string resp;
+  char buff[1024];
+  ssize_t got;
+  while ((got = recv(skt, buff, sizeof(buff), 0)) > 0) resp.append(buff, got);
+  close(skt);
+  size_t start = resp.find("\"WSqueue\":\"");
+  if (start == std::string::npos) return;
+  start += 11;
+  printf("App WSqueue: %s\n", resp.substr(start, resp.find('"', start) - start).c_str());
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: %s <app_ip> [clients] [secs] [slow clients] [sample rate]\n", argv[0]);
+    return 2;
+  }
+  appHost = argv[1];
+  int numClients = argc > 2 ? atoi(argv[2]) : 3;
+  testSecs = argc > 3 ? atoi(argv[3]) : 10;
+  int numSlow = argc > 4 ? atoi(argv[4]) : 0;
+  int sampleRate = argc > 5 ? atoi(argv[5]) : 16000;
+  std::vector<wsTestClient> clients(numClients);
+  for (int i = 0; i < numClients; i++) {
+    clients[i] = {};
+    clients[i].id = i;
+    clients[i].slow = i < numSlow;
+    pthread_create(&clients[i].thread, NULL, clientTask, &clients[i]);
+  }
+  for (auto& client : clients) pthread_join(client.thread, NULL);
+
+  // a normal client must get nearly all audio, a slow client may be dropped by the app
+  bool pass = true;
+  for (auto& client : clients) {
+    float rate = (float)client.samples / testSecs;
+    uint32_t expected = client.audioFrames + client.rx.lost;
+    float lostPct = expected ? 100.0 * client.rx.lost / expected : 0;
+    bool ok = client.slow || (client.connected && !client.closed && rate >= sampleRate * MIN_RATE_PCT / 100.0 && lostPct <= MAX_LOST_PCT);
+    pass &= ok;
+    printf("Client %d%s: %s, audio msgs %u, frames %u, lost %u (%0.1f%%), %0.0f samples/s, spectrum %u, text %u%s\n",
+      client.id, client.slow ? " (slow)" : "", ok ? "ok" : "FAIL", client.audioMsgs, client.audioFrames, client.rx.lost,
+      lostPct, rate, client.spectrum, client.texts, client.closed ? ", closed by app" : "");
+  }
+  showQueueStats();
+  printf("%s\n", pass ? "PASS" : "FAIL");
+  return pass ? 0 : 1;
+}
@@ -211,9 +211,12 @@ void urlDecode(char* inVal);
 bool urlEncode(const char* inVal, char* encoded, size_t maxSize);
 uint32_t usePeripheral(const byte pinNum, const uint32_t receivedData);
 esp_sleep_wakeup_cause_t wakeupResetReason();
-void wsAsyncSendBinary(uint8_t* data, size_t len);
+enum wsTopic {ws_audio = 1, ws_spectrum = 2, ws_log = 4, ws_status = 8}; // websocket subscriptions
+void wsAsyncSendBinary(uint8_t* data, size_t len, bool merge = false, uint8_t topic = ws_audio);
 bool wsAsyncSendJson(const char* dataType, const char* wsData);
-bool wsAsyncSendText(const char* wsData);
+bool wsAsyncSendText(const char* wsData, uint8_t topic = ws_status);
+size_t wsQueueStats(char* p);
+bool wsSubscribed(uint8_t topic);
 // unified networking helpers (WiFi or Ethernet)
 bool startNetwork(bool firstcall = true);
 IPAddress netLocalIP();
@@ -694,7 +694,7 @@ void ledBarGauge(float level) {
     uint8_t fullLedCnt = (uint8_t)(level * LEDBAR_COUNT);
     for (uint8_t i = 0; i < fullLedCnt; i++) ledLevel[i] = LED_FULL;
     // set brightness for most significant lit led
-    ledBrightness(fullLedCnt, (LEDBAR_COUNT * level) - fullLedCnt); 
+    if (fullLedCnt < LEDBAR_COUNT) ledBrightness(fullLedCnt, (LEDBAR_COUNT * level) - fullLedCnt); 
     ledBarUpdate();
   }
 }
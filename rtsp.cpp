@@ -28,6 +28,7 @@
 #else
 #error "Need to install ESP32-RTSPServer library"
 #endif
+#include "RtpPacketiser.h"
 RTSPServer rtspServer;
 
 //Comment out to enable multiple clients for all transports (TCP, UDP, Multicast)
@@ -41,8 +42,8 @@ uint16_t rtpVideoPort;
 uint16_t rtpAudioPort;
 uint16_t rtpSubtitlesPort;
 char RTP_ip[MAX_IP_LEN];
-uint8_t rtspMaxClients;
-uint8_t rtpTTL;
+uint8_t rtspMaxClients = 1;
+uint8_t rtpTTL = 1;
 char RTSP_Name[MAX_HOST_LEN-1] = "";
 char RTSP_Pass[MAX_PWD_LEN-1] = "";
 bool useAuth;
@@ -122,16 +123,68 @@ static void startRTSPSubtitles(void* arg) {
 
 #endif
 
+#if INCLUDE_AUDIO
+
+// Audio output is queued by the audio task in a ring of samples and the sender task
+// is notified of each block, so a late sender catches up rather than losing audio.
+// The sender cuts the ring into packets of rtspPtime ms regardless of the audio
+// block size, see RtpPacketiser.h, and each packet is sent once by the library to all clients.
+// The RTP timestamp is advanced by the library per sample sent, so stays in step
+// with the sample count while no audio is lost.
+#define RTSP_RING_LEN (RTSP_BLOCKS * DMA_BUFF_LEN) // samples, power of 2
+#define RTP_MAX_PAYLOAD 1400 // bytes per packet to avoid IP fragmentation
+#define RTSP_RETRY_MS 5 // wait before retrying when server not ready
+
+int rtspPtime = 20; // ms of audio per RTP packet
+
+static RtpPacketiser rtspPack;
+static TaskHandle_t rtspHandle = NULL;
+static uint32_t rtspSent = 0; // packets sent
+static uint32_t rtspSkipped = 0; // packets discarded while no client ready
+static uint32_t rtspDropped = 0; // blocks lost as ring full
+
+void rtspWrite(const int16_t* samples, size_t numSamples) {
+  // called from audio task to queue block for RTSP sender, never waits
+  if (rtspHandle == NULL || !micGain) return;
+  if (rtspPack.write(samples, numSamples)) xTaskNotifyGive(rtspHandle);
+  else rtspDropped++;
+}
+
+size_t rtspStats(char* p) {
+  // RTSP audio counters as json for web page
+  return sprintf(p, "\"RTSPaudio\":\"%dms packets sent %lu, skipped %lu, blocks dropped %lu, max depth %lu/%d\",", 
+    rtspPtime, rtspSent, rtspSkipped, rtspDropped, rtspPack.maxDepth, RTSP_RING_LEN);
+}
+
+#endif
+
 static void sendRTSPAudio(void* p) {
 #if INCLUDE_AUDIO
-  // send audio chunks via RTSP
-  audioBytes = 0;
-  while (true) {
-    if (micGain && audioBytes && rtspServer.readyToSendAudio()) {
-      rtspServer.sendRTSPAudio((int16_t*)audioBuffer, audioBytes);
-      audioBytes = 0;
-    } 
-    delay(20);
+  // send queued audio as fixed size packets via RTSP when notified by audio task
+  size_t packetLen = rtpPacketLen(SAMPLE_RATE, rtspPtime, RTP_MAX_PAYLOAD);
+  if (packetLen < SAMPLE_RATE * constrain(rtspPtime, 10, 40) / 1000) 
+    LOG_WRN("RTSP ptime %dms too long for %luHz, using %ums", rtspPtime, SAMPLE_RATE, packetLen * 1000 / SAMPLE_RATE);
+  int16_t* ring = (int16_t*)(psramFound() ? ps_malloc(RTSP_RING_LEN * sizeof(int16_t)) : malloc(RTSP_RING_LEN * sizeof(int16_t)));
+  int16_t* packetBuff = (int16_t*)malloc(packetLen * sizeof(int16_t));
+  if (rtspPack.init(ring, RTSP_RING_LEN, packetBuff, packetLen, DMA_BUFF_LEN)) {
+    LOG_INF("RTSP audio sent as %u samples per packet", packetLen);
+    rtspHandle = xTaskGetCurrentTaskHandle();
+  } else {
+    LOG_WRN("Insufficient memory for RTSP audio");
+    free(ring);
+    free(packetBuff);
+  }
+  while (rtspHandle != NULL) {
+    if (!rtspPack.ready()) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    else if (rtspServer.readyToSendAudio()) {
+      rtspServer.sendRTSPAudio((int16_t*)rtspPack.packet(), packetLen * sizeof(int16_t));
+      rtspSent++;
+      rtspPack.advance();
+    } else if (rtspPack.backlogged()) {
+      // no client or client not keeping up, discard oldest to limit latency
+      rtspSkipped++;
+      rtspPack.advance();
+    } else ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RTSP_RETRY_MS));
   }
 #endif
   vTaskDelete(NULL);
@@ -139,7 +192,8 @@ static void sendRTSPAudio(void* p) {
 
 static void initRTSP() {
 #ifdef ISVC
-  // Initialize the RTSP server for VC using constants
+  // Initialize the RTSP server for VC using constants, apart from
+  // rtspMaxClients, rtpTTL and rtspPtime which are configurable
   rtspVideo = rtspSubtitles = false;
   rtspAudio = true;
   strcpy(RTP_ip, "239.255.0.1");
@@ -147,8 +201,6 @@ static void initRTSP() {
   rtpAudioPort = 5432; 
   rtpVideoPort = 0; 
   rtpSubtitlesPort = 0;
-  rtspMaxClients = 1;
-  rtpTTL = 1; 
 #endif
 }
 
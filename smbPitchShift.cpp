@@ -41,88 +41,95 @@
 // - smbPitchShift() to filter in chunks
 // doubles changed to floats for performance
 // s60sc 2023
+//
+// STFT frame is also used for noise suppression, if requested, which is applied
+// to the spectrum before pitch shift analysis, so only one FFT is needed for both.
+// If pitch is not changed the suppressed spectrum is resynthesised directly.
+// s60sc 2026
 
-#include "appGlobals.h"
+#include "smbPitchShift.h"
 
 #define M_PI 3.14159265358979323846
 #define MAX_FRAME_LENGTH 8192
 #define INT_FLT 32768.0
 
-void smbFft(float *fftBuffer, long fftFrameSize, long sign);
 double smbAtan2(double x, double y);
 
-static float* gInFIFO;
-static float* gOutFIFO;
-static float* gFFTworksp;
-static float* gLastPhase;
-static float* gSumPhase;
-static float* gOutputAccum;
-static float* gAnaFreq;
-static float* gAnaMagn;
-static float* gSynFreq;
-static float* gSynMagn;
-
-static long gRover = false, gInit = false;
-static float magn, phase, tmp, window, real, imag;
-static float freqPerBin, expct;
-static long i, k, indexP, qpd, inFifoLatency, stepSize, fftFrameSize, osamp, fftFrameSize2;
-static float pitchShift;
-
 // -----------------------------------------------------------------------------------------------------------------
 
 
-void smbPitchShiftInit(float _pitchShift, long _fftFrameSize, long _osamp, float sampleRate)
+void smbPitchShiftFree(smbState* st)
+/*
+	Release buffers of an instance
+*/
+{
+  free(st->gInFIFO);
+  free(st->gOutFIFO);
+  free(st->gFFTworksp);
+  free(st->gLastPhase);
+  free(st->gSumPhase);
+  free(st->gOutputAccum);
+  free(st->gAnaFreq);
+  free(st->gAnaMagn);
+  free(st->gSynFreq);
+  free(st->gSynMagn);
+  st->gInFIFO = st->gOutFIFO = st->gFFTworksp = st->gLastPhase = st->gSumPhase = NULL;
+  st->gOutputAccum = st->gAnaFreq = st->gAnaMagn = st->gSynFreq = st->gSynMagn = NULL;
+  noiseSuppressFree(&st->ns);
+}
+
+void smbPitchShiftInit(smbState* st, float pitchShift, long fftFrameSize, long osamp, float sampleRate)
 /*
-	Initialisation for smbPitchShift()
+	Initialisation for smbPitchShift(), state must be zeroed before first use
 */
 {
-  pitchShift = _pitchShift;
-  fftFrameSize = _fftFrameSize;
-  osamp = _osamp;
-
-  gInFIFO = (float*)calloc(fftFrameSize, sizeof(float)); 
-  gOutFIFO = (float*)calloc(fftFrameSize, sizeof(float)); 
-  gFFTworksp = (float*)calloc(2*fftFrameSize, sizeof(float));
-  gLastPhase = (float*)calloc(fftFrameSize/2+1, sizeof(float));
-  gSumPhase = (float*)calloc(fftFrameSize/2+1, sizeof(float));
-  gOutputAccum = (float*)calloc(2*fftFrameSize, sizeof(float));
-  gAnaFreq = (float*)calloc(fftFrameSize, sizeof(float));
-  gAnaMagn = (float*)calloc(fftFrameSize, sizeof(float));
-  gSynFreq = (float*)calloc(fftFrameSize, sizeof(float));
-  gSynMagn = (float*)calloc(fftFrameSize, sizeof(float));
+  st->pitchShift = pitchShift;
+  st->fftFrameSize = fftFrameSize;
+  st->osamp = osamp;
+
+  // release any buffers from previous setup
+  smbPitchShiftFree(st);
+  st->gInFIFO = (float*)calloc(fftFrameSize, sizeof(float)); 
+  st->gOutFIFO = (float*)calloc(fftFrameSize, sizeof(float)); 
+  st->gFFTworksp = (float*)calloc(2*fftFrameSize, sizeof(float));
+  st->gLastPhase = (float*)calloc(fftFrameSize/2+1, sizeof(float));
+  st->gSumPhase = (float*)calloc(fftFrameSize/2+1, sizeof(float));
+  st->gOutputAccum = (float*)calloc(2*fftFrameSize, sizeof(float));
+  st->gAnaFreq = (float*)calloc(fftFrameSize, sizeof(float));
+  st->gAnaMagn = (float*)calloc(fftFrameSize, sizeof(float));
+  st->gSynFreq = (float*)calloc(fftFrameSize, sizeof(float));
+  st->gSynMagn = (float*)calloc(fftFrameSize, sizeof(float));
 
 	/* set up some handy variables */
-	fftFrameSize2 = fftFrameSize/2;
-	stepSize = fftFrameSize/osamp;
-	freqPerBin = sampleRate/(float)fftFrameSize;
-	expct = 2.*M_PI*(float)stepSize/(float)fftFrameSize;
-	inFifoLatency = fftFrameSize-stepSize;
-	if (gRover == false) gRover = inFifoLatency;
-
-	/* initialize our static arrays */
-	if (gInit == false) {
-    // not required due to calloc
-		// memset(gInFIFO, 0, MAX_FRAME_LENGTH*sizeof(float));
-		// memset(gOutFIFO, 0, MAX_FRAME_LENGTH*sizeof(float));
-		// memset(gFFTworksp, 0, 2*MAX_FRAME_LENGTH*sizeof(float));
-		// memset(gLastPhase, 0, (MAX_FRAME_LENGTH/2+1)*sizeof(float));
-		// memset(gSumPhase, 0, (MAX_FRAME_LENGTH/2+1)*sizeof(float));
-		// memset(gOutputAccum, 0, 2*MAX_FRAME_LENGTH*sizeof(float));
-		// memset(gAnaFreq, 0, MAX_FRAME_LENGTH*sizeof(float));
-		// memset(gAnaMagn, 0, MAX_FRAME_LENGTH*sizeof(float));
-		gInit = true;
-	}
+	st->fftFrameSize2 = fftFrameSize/2;
+	st->stepSize = fftFrameSize/osamp;
+	st->freqPerBin = sampleRate/(float)fftFrameSize;
+	st->expct = 2.*M_PI*(float)st->stepSize/(float)fftFrameSize;
+	st->inFifoLatency = fftFrameSize-st->stepSize;
+	st->gRover = st->inFifoLatency; // buffers are new so restart fifo
+	// arrays zeroed by calloc
 }
 
-void smbPitchShift(size_t numSampsToProcess, int16_t *indata, int16_t *outdata) {
+void smbPitchShift(smbState* st, size_t numSampsToProcess, int16_t *indata, int16_t *outdata, bool denoise) {
   /*
 	Routine smbPitchShift(). See top of file for explanation
 	Purpose: doing pitch shifting while maintaining duration using the Short
 	Time Fourier Transform.
 	Author: (c)1999-2009 Stephan M. Bernsee <smb [AT] dspdimension [DOT] com>
   */
+	/* local copies of instance state */
+	float *gInFIFO = st->gInFIFO, *gOutFIFO = st->gOutFIFO, *gFFTworksp = st->gFFTworksp;
+	float *gLastPhase = st->gLastPhase, *gSumPhase = st->gSumPhase, *gOutputAccum = st->gOutputAccum;
+	float *gAnaFreq = st->gAnaFreq, *gAnaMagn = st->gAnaMagn, *gSynFreq = st->gSynFreq, *gSynMagn = st->gSynMagn;
+	long gRover = st->gRover, inFifoLatency = st->inFifoLatency, stepSize = st->stepSize;
+	long fftFrameSize = st->fftFrameSize, osamp = st->osamp, fftFrameSize2 = st->fftFrameSize2;
+	float freqPerBin = st->freqPerBin, expct = st->expct, pitchShift = st->pitchShift;
+	float magn, phase, tmp, window, real, imag;
+	long i, k, indexP, qpd;
+	if (gInFIFO == NULL) return;
+
 	/* main processing loop */
-	for (i = 0; i < numSampsToProcess; i++){
+	for (i = 0; i < (long)numSampsToProcess; i++){
 
 		/* As long as we have not yet collected enough data just read in */
 		gInFIFO[gRover] = (float)(indata[i]) / INT_FLT; // convert from int16_t to float
@@ -145,82 +152,96 @@ void smbPitchShift(size_t numSampsToProcess, int16_t *indata, int16_t *outdata)
 			/* do transform */
 			smbFft(gFFTworksp, fftFrameSize, -1);
 
-			/* this is the analysis step */
-			for (k = 0; k <= fftFrameSize2; k++) {
-
-				/* de-interlace FFT buffer */
-				real = gFFTworksp[2*k];
-				imag = gFFTworksp[2*k+1];
-
-				/* compute magnitude and phase */
-				magn = 2.*sqrt(real*real + imag*imag);
-				phase = atan2(imag,real);
-
-				/* compute phase difference */
-				tmp = phase - gLastPhase[k];
-				gLastPhase[k] = phase;
+			/* attenuate noise in spectrum before any pitch shift analysis */
+			if (denoise) noiseSuppress(&st->ns, gFFTworksp, fftFrameSize2);
+
+			if (pitchShift != 1.0) {
+				/* this is the analysis step */
+				for (k = 0; k <= fftFrameSize2; k++) {
+
+					/* de-interlace FFT buffer */
+					real = gFFTworksp[2*k];
+					imag = gFFTworksp[2*k+1];
+
+					/* compute magnitude and phase */
+					magn = 2.*sqrt(real*real + imag*imag);
+					phase = atan2(imag,real);
+
+					/* compute phase difference */
+					tmp = phase - gLastPhase[k];
+					gLastPhase[k] = phase;
+
+					/* subtract expected phase difference */
+					tmp -= (float)k*expct;
+
+					/* map delta phase into +/- Pi interval */
+					qpd = tmp/M_PI;
+					if (qpd >= 0) qpd += qpd&1;
+					else qpd -= qpd&1;
+					tmp -= M_PI*(float)qpd;
+
+					/* get deviation from bin frequency from the +/- Pi interval */
+					tmp = osamp*tmp/(2.*M_PI);
+
+					/* compute the k-th partials' true frequency */
+					tmp = (float)k*freqPerBin + tmp*freqPerBin;
+
+					/* store magnitude and true frequency in analysis arrays */
+					gAnaMagn[k] = magn;
+					gAnaFreq[k] = tmp;
+
+				}
+
+				/* ***************** PROCESSING ******************* */
+				/* this does the actual pitch shifting */
+				memset(gSynMagn, 0, fftFrameSize*sizeof(float));
+				memset(gSynFreq, 0, fftFrameSize*sizeof(float));
+				for (k = 0; k <= fftFrameSize2; k++) { 
+					indexP = k*pitchShift;
+					if (indexP <= fftFrameSize2) { 
+						gSynMagn[indexP] += gAnaMagn[k]; 
+						gSynFreq[indexP] = gAnaFreq[k] * pitchShift; 
+					} 
+				}
+			
+				/* ***************** SYNTHESIS ******************* */
+				/* this is the synthesis step */
+				for (k = 0; k <= fftFrameSize2; k++) {
 
-				/* subtract expected phase difference */
-				tmp -= (float)k*expct;
+					/* get magnitude and true frequency from synthesis arrays */
+					magn = gSynMagn[k];
+					tmp = gSynFreq[k];
 
-				/* map delta phase into +/- Pi interval */
-				qpd = tmp/M_PI;
-				if (qpd >= 0) qpd += qpd&1;
-				else qpd -= qpd&1;
-				tmp -= M_PI*(float)qpd;
+					/* subtract bin mid frequency */
+					tmp -= (float)k*freqPerBin;
 
-				/* get deviation from bin frequency from the +/- Pi interval */
-				tmp = osamp*tmp/(2.*M_PI);
+					/* get bin deviation from freq deviation */
+					tmp /= freqPerBin;
 
-				/* compute the k-th partials' true frequency */
-				tmp = (float)k*freqPerBin + tmp*freqPerBin;
+					/* take osamp into account */
+					tmp = 2.*M_PI*tmp/osamp;
 
-				/* store magnitude and true frequency in analysis arrays */
-				gAnaMagn[k] = magn;
-				gAnaFreq[k] = tmp;
+					/* add the overlap phase advance back in */
+					tmp += (float)k*expct;
 
-			}
+					/* accumulate delta phase to get bin phase */
+					gSumPhase[k] += tmp;
+					phase = gSumPhase[k];
 
-			/* ***************** PROCESSING ******************* */
-			/* this does the actual pitch shifting */
-			memset(gSynMagn, 0, fftFrameSize*sizeof(float));
-			memset(gSynFreq, 0, fftFrameSize*sizeof(float));
-			for (k = 0; k <= fftFrameSize2; k++) { 
-				indexP = k*pitchShift;
-				if (indexP <= fftFrameSize2) { 
-					gSynMagn[indexP] += gAnaMagn[k]; 
-					gSynFreq[indexP] = gAnaFreq[k] * pitchShift; 
+					/* get real and imag part and re-interleave */
+					gFFTworksp[2*k] = magn*cos(phase);
+					gFFTworksp[2*k+1] = magn*sin(phase);
 				} 
-			}
-			
-			/* ***************** SYNTHESIS ******************* */
-			/* this is the synthesis step */
-			for (k = 0; k <= fftFrameSize2; k++) {
-
-				/* get magnitude and true frequency from synthesis arrays */
-				magn = gSynMagn[k];
-				tmp = gSynFreq[k];
-
-				/* subtract bin mid frequency */
-				tmp -= (float)k*freqPerBin;
 
-				/* get bin deviation from freq deviation */
-				tmp /= freqPerBin;
-
-				/* take osamp into account */
-				tmp = 2.*M_PI*tmp/osamp;
-
-				/* add the overlap phase advance back in */
-				tmp += (float)k*expct;
-
-				/* accumulate delta phase to get bin phase */
-				gSumPhase[k] += tmp;
-				phase = gSumPhase[k];
-
-				/* get real and imag part and re-interleave */
-				gFFTworksp[2*k] = magn*cos(phase);
-				gFFTworksp[2*k+1] = magn*sin(phase);
-			} 
+				/* share pitch shifted spectrum with analyzer */
+				if (st->shareSpectrum) spectrumBins(gSynMagn, fftFrameSize2);
+			} else {
+				/* pitch unchanged, so resynthesise from positive frequencies at same scale as above */
+				for (k = 0; k <= fftFrameSize2; k++) {
+					gFFTworksp[2*k] *= 2.;
+					gFFTworksp[2*k+1] *= 2.;
+				}
+			}
 
 			/* zero negative frequencies */
 			for (k = fftFrameSize+2; k < 2*fftFrameSize; k++) gFFTworksp[k] = 0.;
@@ -242,6 +263,7 @@ void smbPitchShift(size_t numSampsToProcess, int16_t *indata, int16_t *outdata)
 			for (k = 0; k < inFifoLatency; k++) gInFIFO[k] = gInFIFO[k+stepSize];
 		}
 	}
+	st->gRover = gRover;
 }
 
 // -----------------------------------------------------------------------------------------------------------------
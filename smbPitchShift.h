@@ -0,0 +1,46 @@
+//
+// smbPitchShift.h
+//
+// State of an STFT pitch shift / noise suppression instance, so that live audio
+// and offline rendering each have their own.
+//
+// s60sc 2026
+
+#pragma once
+#include "appGlobals.h"
+
+struct nsState {
+  float* smoothPow; // smoothed power per bin
+  float* currMin; // minimum of current sub window
+  float* subMin; // minima of completed sub windows
+  float* noisePow; // minimum over completed sub windows
+  float* prevClean; // previous frame estimate of clean power
+  long nsBins;
+  int subLen, subIdx, frameCnt;
+  float alpha, gainFloor;
+  bool firstFrame;
+};
+
+struct smbState {
+  float* gInFIFO;
+  float* gOutFIFO;
+  float* gFFTworksp;
+  float* gLastPhase;
+  float* gSumPhase;
+  float* gOutputAccum;
+  float* gAnaFreq;
+  float* gAnaMagn;
+  float* gSynFreq;
+  float* gSynMagn;
+  long gRover, inFifoLatency, stepSize, fftFrameSize, osamp, fftFrameSize2;
+  float freqPerBin, expct, pitchShift;
+  bool shareSpectrum; // pass synthesis magnitudes to analyzer
+  nsState ns;
+};
+
+void smbPitchShiftInit(smbState* st, float pitchShift, long fftFrameSize, long osamp, float sampleRate);
+void smbPitchShift(smbState* st, size_t numSampsToProcess, int16_t *indata, int16_t *outdata, bool denoise = false);
+void smbPitchShiftFree(smbState* st);
+void noiseSuppressInit(nsState* ns, long fftFrameSize, long stepSize, float sampleRate, int level);
+void noiseSuppress(nsState* ns, float* fftBuffer, long fftFrameSize2);
+void noiseSuppressFree(nsState* ns);
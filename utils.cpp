@@ -906,14 +906,37 @@ float readInternalTemp() {
  * - To clear the log file contents, on log web page press Clear Log link
  */
  
+/*
+ * logPrint() never blocks the caller. Each message is queued as a record in a
+ * lock free ring (bounded multi producer queue), holding the format string pointer 
+ * and the raw argument values, with any strings copied. Formatting is deferred to 
+ * the low priority logTask which drains the ring and outputs each message.
+ * If the format string is not in flash, the message is formatted immediately.
+ * If the ring is full, or the message is raised by logTask itself, the message
+ * is dropped, and the number dropped is logged.
+ */
+
+#include <atomic>
+#include "esp_memory_utils.h"
+
 #define MAX_OUT 200
-static va_list arglist;
-static char fmtBuf[MAX_OUT];
+#define LOG_SLOTS 32 // queued records, power of 2, doubled if PSRAM
+#define LOG_DATA_LEN MAX_OUT // space in record for argument values or formatted message
+#define LOG_SPEC_LEN 16 // max length of a conversion spec
+
+struct logRecord {
+  std::atomic<uint32_t> seq; // ring position record is ready for
+  const char* format; // format string in flash, or NULL if data holds formatted message
+  char data[LOG_DATA_LEN]; // argument values in order of format string
+};
+
+static logRecord* logRing = NULL;
+static uint32_t logMask;
+static std::atomic<uint32_t> logHead(0); // next record to be claimed by producer
+static uint32_t logTail = 0; // next record to be output, only used by logTask
+static std::atomic<uint32_t> logDropped(0);
 static char outBuf[MAX_OUT];
 TaskHandle_t logHandle = NULL;
-static SemaphoreHandle_t logSemaphore = NULL;
-static SemaphoreHandle_t logMutex = NULL;
-static int logWait = 100; // ms
 bool useLogColors = false;  // true to colorise log messages (eg if using idf.py, but not arduino)
 
 #define WRITE_CACHE_CYCLE 5
@@ -994,53 +1017,240 @@ void remote_log_init() {
   } else flush_log(true);
 }
 
-static void logTask(void *arg) {
-  // separate task to reduce stack size in other tasks
-  while(true) {
-    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-    vsnprintf(outBuf, MAX_OUT, fmtBuf, arglist);
-    va_end(arglist);
-    xSemaphoreGive(logSemaphore);
+static const char* logParseSpec(const char* p, char* spec, char& conv, int& stars, bool& wide) {
+  // copy conversion spec following '%' into spec, returns pointer past conversion char
+  size_t i = 0;
+  spec[i++] = '%';
+  stars = 0;
+  wide = false;
+  while (*p && strchr("-+ #0123456789.*hljztL", *p)) {
+    if (*p == '*') stars++;
+    if ((*p == 'l' && p[1] == 'l') || *p == 'j') wide = true; // 64 bit integer
+    if (i < LOG_SPEC_LEN - 2) spec[i++] = *p;
+    p++;
   }
+  conv = *p;
+  spec[i++] = conv;
+  spec[i] = 0;
+  return *p ? p + 1 : p;
 }
 
-void logPrint(const char *format, ...) {
-  // feeds logTask to format message, then outputs as required
-  if (logMutex == NULL) logSetup();
-  if (xSemaphoreTake(logMutex, pdMS_TO_TICKS(logWait)) == pdTRUE) {
-    strncpy(fmtBuf, format, MAX_OUT);
-    va_start(arglist, format); 
-    vTaskPrioritySet(logHandle, uxTaskPriorityGet(NULL) + 1);
-    xTaskNotifyGive(logHandle);
-    outBuf[MAX_OUT - 2] = '\n'; 
-    outBuf[MAX_OUT - 1] = 0; // ensure always have ending newline
-    xSemaphoreTake(logSemaphore, portMAX_DELAY); // wait for logTask to complete
-
-    // output message to various recipients
-    size_t msgLen = strlen(outBuf);
-    if (msgLen > 1) {
+static bool logPut(logRecord* rec, size_t& len, const void* val, size_t valLen) {
+  if (len + valLen > LOG_DATA_LEN) return false;
+  memcpy(rec->data + len, val, valLen);
+  len += valLen;
+  return true;
+}
+
+static bool logCapture(logRecord* rec, const char* format, va_list args) {
+  // store argument values for deferred formatting, false if unable
+  char spec[LOG_SPEC_LEN];
+  char conv;
+  int stars;
+  bool wide;
+  size_t len = 0;
+  for (const char* p = format; *p; ) {
+    if (*p++ != '%') continue;
+    p = logParseSpec(p, spec, conv, stars, wide);
+    for (int s = 0; s < stars; s++) {
+      int starVal = va_arg(args, int);
+      if (!logPut(rec, len, &starVal, sizeof(starVal))) return false;
+    }
+    switch (conv) {
+      case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+        if (wide) {
+          long long val = va_arg(args, long long);
+          if (!logPut(rec, len, &val, sizeof(val))) return false;
+        } else {
+          int val = va_arg(args, int);
+          if (!logPut(rec, len, &val, sizeof(val))) return false;
+        }
+      break;
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+        double val = va_arg(args, double);
+        if (!logPut(rec, len, &val, sizeof(val))) return false;
+      }
+      break;
+      case 'p': {
+        void* val = va_arg(args, void*);
+        if (!logPut(rec, len, &val, sizeof(val))) return false;
+      }
+      break;
+      case 's': {
+        // copy string as may not persist, truncated to available space
+        const char* val = va_arg(args, const char*);
+        if (val == NULL) val = "(null)";
+        if (len >= LOG_DATA_LEN) return false;
+        size_t strLen = strnlen(val, LOG_DATA_LEN - len - 1);
+        memcpy(rec->data + len, val, strLen);
+        rec->data[len + strLen] = 0;
+        len += strLen + 1;
+      }
+      break;
+      case '%':
+      break;
+      default:
+        return false; // unsupported conversion
+    }
+  }
+  return true;
+}
+
+template <typename T> 
+static int logFormatArg(char* out, size_t outLen, const char* spec, int stars, const int* starVals, T val) {
+  switch (stars) {
+    case 0: return snprintf(out, outLen, spec, val);
+    case 1: return snprintf(out, outLen, spec, starVals[0], val);
+    default: return snprintf(out, outLen, spec, starVals[0], starVals[1], val);
+  }
+}
+
+template <typename T> 
+static T logGet(logRecord* rec, size_t& pos) {
+  T val;
+  memcpy(&val, rec->data + pos, sizeof(T));
+  pos += sizeof(T);
+  return val;
+}
+
+static size_t logFormat(logRecord* rec) {
+  // format message from record into outBuf, returns message length
+  if (rec->format == NULL) {
+    strncpy(outBuf, rec->data, MAX_OUT);
+    return strlen(outBuf);
+  }
+  char spec[LOG_SPEC_LEN];
+  char conv;
+  int stars;
+  bool wide;
+  size_t out = 0, pos = 0;
+  for (const char* p = rec->format; *p && out < MAX_OUT - 1; ) {
+    if (*p != '%') {
+      outBuf[out++] = *p++;
+      continue;
+    }
+    p = logParseSpec(p + 1, spec, conv, stars, wide);
+    int starVals[2] = {0, 0};
+    for (int s = 0; s < stars; s++) starVals[std::min(s, 1)] = logGet<int>(rec, pos);
+    char* dest = outBuf + out;
+    size_t room = MAX_OUT - out;
+    int fmtLen = 0;
+    switch (conv) {
+      case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+        if (wide) fmtLen = logFormatArg(dest, room, spec, stars, starVals, logGet<long long>(rec, pos));
+        else fmtLen = logFormatArg(dest, room, spec, stars, starVals, logGet<int>(rec, pos));
+      break;
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        fmtLen = logFormatArg(dest, room, spec, stars, starVals, logGet<double>(rec, pos));
+      break;
+      case 'p':
+        fmtLen = logFormatArg(dest, room, spec, stars, starVals, logGet<void*>(rec, pos));
+      break;
+      case 's': {
+        const char* val = rec->data + pos;
+        pos += strlen(val) + 1;
+        fmtLen = logFormatArg(dest, room, spec, stars, starVals, val);
+      }
+      break;
+      case '%':
+        *dest = '%';
+        fmtLen = 1;
+      break;
+    }
+    out += std::min((size_t)std::max(fmtLen, 0), room - 1);
+  }
+  outBuf[out] = 0;
+  if (out >= MAX_OUT - 1) outBuf[MAX_OUT - 2] = '\n'; // ensure always have ending newline
+  return out;
+}
+
+static void logOutput(size_t msgLen) {
+  // output formatted message to various recipients
+  TRACE_BEGIN(trc_log_write);
+  if (msgLen > 1) {
 #ifdef AUXILIARY
-      sendSSE("log", outBuf);
+    sendSSE("log", outBuf);
 #else
-      wsAsyncSendText(outBuf); // output to browser over web socket
+    wsAsyncSendText(outBuf, ws_log); // output to browser over web socket
 #endif
-      if (outBuf[msgLen - 2] == '~') outBuf[msgLen - 2] = ' '; // remove '~' if present
+    if (outBuf[msgLen - 2] == '~') outBuf[msgLen - 2] = ' '; // remove '~' if present
+  }
+  if (monitorOpen) Serial.print(outBuf); // output to monitor console if attached
+  if (msgLen > 1) {
+    ramLogStore(msgLen); // store in rtc ram 
+    if (sdLog) {
+      if (log_remote_fp != NULL) {
+        // output to SD if file opened
+        fwrite(outBuf, sizeof(char), msgLen, log_remote_fp); // log.txt
+        // periodic sync to SD
+        if (counter_write++ % WRITE_CACHE_CYCLE == 0) fsync(fileno(log_remote_fp));
+      } 
     }
-    if (monitorOpen) Serial.print(outBuf); // output to monitor console if attached
-    else delay(10); // allow time for other tasks
-    if (msgLen > 1) {
-      ramLogStore(msgLen); // store in rtc ram 
-      if (sdLog) {
-        if (log_remote_fp != NULL) {
-          // output to SD if file opened
-          fwrite(outBuf, sizeof(char), msgLen, log_remote_fp); // log.txt
-          // periodic sync to SD
-          if (counter_write++ % WRITE_CACHE_CYCLE == 0) fsync(fileno(log_remote_fp));
-        } 
+  }
+  TRACE_END(trc_log_write);
+}
+
+static void logTask(void *arg) {
+  // drain queued log records, formatting and outputting each in turn
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    logRecord* rec = &logRing[logTail & logMask];
+    while (rec->seq.load(std::memory_order_acquire) == logTail + 1) {
+      size_t msgLen = logFormat(rec);
+      // release record for reuse before output
+      rec->seq.store(logTail + logMask + 1, std::memory_order_release);
+      logTail++;
+      logOutput(msgLen);
+      uint32_t dropped = logDropped.exchange(0);
+      if (dropped) {
+        snprintf(outBuf, MAX_OUT, WRN_FORMAT("%lu log messages dropped~"), dropped);
+        logOutput(strlen(outBuf));
       }
+      rec = &logRing[logTail & logMask];
     }
-    xSemaphoreGive(logMutex);
-  } 
+  }
+}
+
+void logPrint(const char *format, ...) {
+  // queue message for logTask to format and output, never blocks
+  if (logRing == NULL) logSetup();
+  // drop messages raised while outputting a message, to avoid feedback
+  if (logHandle != NULL && xTaskGetCurrentTaskHandle() == logHandle) {
+    logDropped++;
+    return;
+  }
+
+  // claim next free record
+  logRecord* rec;
+  uint32_t pos = logHead.load(std::memory_order_relaxed);
+  while (true) {
+    rec = &logRing[pos & logMask];
+    int32_t diff = (int32_t)(rec->seq.load(std::memory_order_acquire) - pos);
+    if (diff == 0) {
+      if (logHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      logDropped++; // ring full
+      return;
+    } else pos = logHead.load(std::memory_order_relaxed);
+  }
+
+  // store arguments, or formatted message if unable
+  va_list args;
+  va_start(args, format);
+  va_list capArgs;
+  va_copy(capArgs, args);
+  bool captured = esp_ptr_in_drom(format) && logCapture(rec, format, capArgs);
+  va_end(capArgs);
+  if (captured) rec->format = format;
+  else {
+    rec->format = NULL;
+    if (vsnprintf(rec->data, LOG_DATA_LEN, format, args) >= LOG_DATA_LEN) rec->data[LOG_DATA_LEN - 2] = '\n';
+  }
+  va_end(args);
+
+  // publish record to logTask
+  rec->seq.store(pos + 1, std::memory_order_release);
+  if (logHandle != NULL) xTaskNotifyGive(logHandle);
 }
 
 void logLine() {
@@ -1057,7 +1267,7 @@ int vprintfRedirect(const char* format, va_list args) {
 
 void logSetup() {
   // prep logging environment
-  if (logMutex == NULL) {
+  if (logRing == NULL) {
     set_arduino_panic_handler(appPanicHandler, NULL);
 #if CONFIG_IDF_TARGET_ESP32S3
    HEAP_MEM = psramFound() ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL;
@@ -1073,10 +1283,15 @@ void logSetup() {
     esp_log_set_vprintf(vprintfRedirect); // redirect esp_log output to app log
     if (crashLoop == MAGIC_NUM) snprintf(startupFailure, SF_LEN, STARTUP_FAIL "Crash loop detected, check log %s", (brownoutStatus == 'B' || brownoutStatus == 'R') ? "(brownout)" : " ");
     crashLoop = MAGIC_NUM;
-    logSemaphore = xSemaphoreCreateBinary(); // flag that log message formatted
-    logMutex = xSemaphoreCreateMutex(); // control access to log formatter
-    xSemaphoreGive(logSemaphore);
-    xSemaphoreGive(logMutex);
+    // log ring held in PSRAM if available
+    size_t logSlots = psramFound() ? LOG_SLOTS * 2 : LOG_SLOTS;
+    logRing = (logRecord*)heap_caps_malloc(logSlots * sizeof(logRecord), psramFound() ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL);
+    if (logRing == NULL) {
+      logSlots = LOG_SLOTS;
+      logRing = (logRecord*)heap_caps_malloc(logSlots * sizeof(logRecord), MALLOC_CAP_INTERNAL);
+    }
+    for (size_t i = 0; i < logSlots; i++) new (&logRing[i].seq) std::atomic<uint32_t>(i);
+    logMask = logSlots - 1;
     xTaskCreateWithCaps(logTask, "logTask", LOG_STACK_SIZE, NULL, LOG_PRI, &logHandle, HEAP_MEM);
     if (mlogEnd >= RAM_LOG_LEN) ramLogClear(); // init
     logPrint("\n\n=============== %s %s ===============\n", APP_NAME, APP_VER);
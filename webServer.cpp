@@ -4,7 +4,7 @@
 
 #include "appGlobals.h"
 
-#define MAX_HANDLERS 12
+#define MAX_HANDLERS 14
 
 char inFileName[IN_FILE_NAME_LEN];
 static char variable[FILE_NAME_LEN]; 
@@ -13,7 +13,6 @@ static char retainAction[2];
 int refreshVal = 5000; // msecs
 
 static httpd_handle_t httpServer = NULL; // web server port
-static int fdWs = -1; // websocket sockfd
 static httpd_handle_t sseSocketHD; // SSE support
 static int sseSocketFD;
 bool useHttps = false;
@@ -21,6 +20,39 @@ bool useSecure = false;
 bool heartBeatDone = false;
 
 static byte* chunk;
+static void wsCloseClients();
+
+// static web page assets, served gzipped if available, and validated by ETag
+#define ASSET_CACHE 8 // storage files with known ETag
+#define ETAG_LEN 19 // quoted 64 bit hash in hex
+#define GZ_HDR_LEN 10 // fixed part of gzip header
+#define GZ_FEXTRA 0x04 // gzip header flags
+#define GZ_FNAME 0x08
+#define GZ_FCOMMENT 0x10
+
+struct webAsset {
+  const char* path; // storage path of original file
+  const char* etag;
+  const uint8_t* data; // gzipped content
+  size_t len;
+};
+
+#if INCLUDE_WEB_ASSETS
+#include "webAssets.h" // generated by extras/makeWebAssets.py
+#else
+static const webAsset webAssets[] = {{NULL, NULL, NULL, 0}};
+#define WEB_ASSET_COUNT 0
+#endif
+
+struct assetEtag {
+  char path[FILE_NAME_LEN];
+  size_t size;
+  time_t written;
+  char etag[ETAG_LEN + 1];
+};
+static assetEtag assetEtags[ASSET_CACHE];
+static int nextEtag = 0;
+static char respEtag[ETAG_LEN + 1]; // header values must persist till response sent
 
 esp_err_t sendChunks(File df, httpd_req_t *req, bool endChunking) {   
   // use chunked encoding to send large content to browser
@@ -58,6 +90,107 @@ esp_err_t fileHandler(httpd_req_t* req, bool download) {
   return (download) ? downloadFile(df, req) : sendChunks(df, req);
 }
 
+static const webAsset* findAsset(const char* path) {
+  // embedded asset for storage path, if bundled
+  for (int i = 0; i < WEB_ASSET_COUNT; i++) 
+    if (!strcmp(webAssets[i].path, path)) return &webAssets[i];
+  return NULL;
+}
+
+static const char* fileEtag(File& df) {
+  // ETag from FNV-1a hash of file content, only rehashed if file changed
+  char path[FILE_NAME_LEN];
+  snprintf(path, FILE_NAME_LEN, "%s", df.path());
+  size_t size = df.size();
+  time_t written = df.getLastWrite();
+  for (int i = 0; i < ASSET_CACHE; i++) {
+    assetEtag* ae = &assetEtags[i];
+    if (!strcmp(ae->path, path) && ae->size == size && ae->written == written) return ae->etag;
+  }
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  size_t chunksize;
+  while ((chunksize = df.read(chunk, CHUNKSIZE))) 
+    for (size_t i = 0; i < chunksize; i++) hash = (hash ^ chunk[i]) * 0x100000001b3ULL;
+  df.seek(0);
+  assetEtag* ae = &assetEtags[nextEtag++ % ASSET_CACHE];
+  strcpy(ae->path, path);
+  ae->size = size;
+  ae->written = written;
+  snprintf(ae->etag, ETAG_LEN + 1, "\"%016llx\"", hash);
+  return ae->etag;
+}
+
+static bool gzCurrent(File& gz, const char* srcEtag) {
+  // check .gz was made from current original, from hash of original held in gzip 
+  // comment field by extras/makeWebAssets.py, as file times are not reliable
+  uint8_t hdr[GZ_HDR_LEN];
+  char comment[ETAG_LEN];
+  bool current = false;
+  if (gz.read(hdr, GZ_HDR_LEN) == GZ_HDR_LEN && hdr[0] == 0x1f && hdr[1] == 0x8b && (hdr[3] & GZ_FCOMMENT)) {
+    if (hdr[3] & GZ_FEXTRA) {
+      uint8_t xlen[2];
+      if (gz.read(xlen, 2) == 2) gz.seek(gz.position() + (xlen[0] | xlen[1] << 8));
+    }
+    if (hdr[3] & GZ_FNAME) while (gz.available() && gz.read()) {}
+    size_t len = 0;
+    int c;
+    while (len < ETAG_LEN - 1 && (c = gz.read()) > 0) comment[len++] = c;
+    // srcEtag is quoted hash
+    current = len == ETAG_LEN - 3 && !strncmp(comment, srcEtag + 1, len);
+  }
+  gz.seek(0);
+  return current;
+}
+
+static bool notModified(httpd_req_t* req, const char* etag) {
+  // send ETag, or 304 response if browser copy is current
+  char hdrVal[IN_FILE_NAME_LEN];
+  strcpy(respEtag, etag);
+  httpd_resp_set_hdr(req, "ETag", respEtag);
+  if (extractHeaderVal(req, "If-None-Match", hdrVal) != ESP_OK || strstr(hdrVal, etag) == NULL) return false;
+  httpd_resp_set_status(req, "304 Not Modified");
+  httpd_resp_send(req, NULL, 0);
+  return true;
+}
+
+static esp_err_t assetHandler(httpd_req_t* req) {
+  // send static web page component in inFileName, from embedded bundle if present,
+  // else from storage using precompressed .gz version if present and up to date
+  char hdrVal[IN_FILE_NAME_LEN];
+  bool gzipOk = extractHeaderVal(req, "Accept-Encoding", hdrVal) == ESP_OK && strstr(hdrVal, "gzip") != NULL;
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+  const webAsset* asset = findAsset(inFileName);
+  if (asset != NULL && gzipOk) {
+    if (notModified(req, asset->etag)) return ESP_OK;
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char*)asset->data, asset->len);
+  }
+
+  File df = STORAGE.open(inFileName);
+  if (!df) {
+    LOG_WRN("File does not exist or cannot be opened: %s", inFileName);
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+  }
+  if (gzipOk) {
+    char gzName[IN_FILE_NAME_LEN];
+    snprintf(gzName, IN_FILE_NAME_LEN, "%s.gz", inFileName);
+    File gz = STORAGE.exists(gzName) ? STORAGE.open(gzName) : File();
+    // ignore stale .gz if original since replaced
+    if (gz && gzCurrent(gz, fileEtag(df))) {
+      df.close();
+      df = gz;
+      httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    } else if (gz) gz.close();
+  }
+  if (notModified(req, fileEtag(df))) {
+    df.close();
+    return ESP_OK;
+  }
+  return sendChunks(df, req);
+}
+
 static void displayLog(httpd_req_t *req) {
   // output ram log to browser
   if (logType == 0) {
@@ -115,13 +248,14 @@ static esp_err_t indexHandler(httpd_req_t* req) {
     return ESP_OK;
   } 
   // Show wifi wizard if not setup, using access point mode
-  if (!STORAGE.exists(INDEX_PAGE_PATH) && WiFi.status() != WL_CONNECTED) {
+  if (findAsset(INDEX_PAGE_PATH) == NULL && !STORAGE.exists(INDEX_PAGE_PATH) && WiFi.status() != WL_CONNECTED) {
     // Open a basic wifi setup page
     httpd_resp_set_type(req, "text/html");
     return httpd_resp_sendstr(req, setupPage_html);
   } else if (!checkAuth(req)) return ESP_OK; // check if authentication required & passed
 
-  return fileHandler(req);
+  httpd_resp_set_hdr(req, "Cache-Control", "no-cache"); // revalidate using ETag
+  return assetHandler(req);
 }
 
 esp_err_t extractHeaderVal(httpd_req_t *req, const char* variable, char* value) {
@@ -163,6 +297,7 @@ static esp_err_t webHandler(httpd_req_t* req) {
   urlDecode(variable);
 
   // check file extension to determine required processing before response sent to browser
+  bool isAsset = true; // static page component rather than data file
   if (!strcmp(variable, "OTA.htm")) {
     // request for built in OTA page, if index html defective
     httpd_resp_set_type(req, "text/html"); 
@@ -170,6 +305,7 @@ static esp_err_t webHandler(httpd_req_t* req) {
   } else if (!strcmp(HTML_EXT, variable+(strlen(variable)-strlen(HTML_EXT)))) {
     // any other html file
     httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache"); // revalidate using ETag
   } else if (!strcmp(JS_EXT, variable+(strlen(variable)-strlen(JS_EXT)))) {
     // any js file
     httpd_resp_set_type(req, "text/javascript");
@@ -181,16 +317,20 @@ static esp_err_t webHandler(httpd_req_t* req) {
   } else if (!strcmp(TEXT_EXT, variable+(strlen(variable)-strlen(TEXT_EXT)))) {
     // any text file
     httpd_resp_set_type(req, "text/plain");
+    isAsset = false;
   } else if (!strcmp(ICO_EXT, variable+(strlen(variable)-strlen(ICO_EXT)))) {
     // any icon file
     httpd_resp_set_type(req, "image/x-icon");
   } else if (!strcmp(SVG_EXT, variable+(strlen(variable)-strlen(SVG_EXT)))) {
     // any svg file
     httpd_resp_set_type(req, "image/svg+xml");
-  } else LOG_WRN("Unknown file type %s", variable);  
+  } else {
+    LOG_WRN("Unknown file type %s", variable);  
+    isAsset = false;
+  }
   int dlen = snprintf(inFileName, IN_FILE_NAME_LEN - 1, "%s/%s", DATA_DIR, variable);               
   if (dlen >= IN_FILE_NAME_LEN) LOG_WRN("file name truncated");
-  return fileHandler(req);
+  return isAsset ? assetHandler(req) : fileHandler(req);
 }
 
 static esp_err_t controlHandler(httpd_req_t *req) {
@@ -209,7 +349,9 @@ static esp_err_t controlHandler(httpd_req_t *req) {
     if (!strcmp(variable, "startOTA")) snprintf(inFileName, IN_FILE_NAME_LEN - 1, "%s/%s", DATA_DIR, value); 
     else {
       // if not handled by appSpecificWebHandler(), try updateStatus()
-      if (appSpecificWebHandler(req, variable, value) == ESP_FAIL) updateStatus(variable, value);
+      esp_err_t res = appSpecificWebHandler(req, variable, value);
+      if (res == ESP_FAIL) updateStatus(variable, value);
+      else if (res == ESP_ERR_NOT_FINISHED) return ESP_OK; // response to be sent by async task
     }
   }
   httpd_resp_sendstr(req, NULL); 
@@ -218,9 +360,11 @@ static esp_err_t controlHandler(httpd_req_t *req) {
 
 static esp_err_t statusHandler(httpd_req_t *req) {
   uint8_t filter = (uint8_t)httpd_req_get_url_query_len(req); // filter number is length of query string
+  TRACE_BEGIN(trc_status_req);
   buildJsonString(filter);
   httpd_resp_set_type(req, "application/json");
   httpd_resp_sendstr(req, jsonBuff);
+  TRACE_END(trc_status_req);
   return ESP_OK;
 }
 
@@ -317,7 +461,7 @@ esp_err_t uploadHandler(httpd_req_t *req) {
     // partition update - sketch or SPIFFS
     LOG_INF("Firmware update using file %s", inFileName);
     OTAprereq();
-    if (fdWs >= 0) httpd_sess_trigger_close(httpServer, fdWs);
+    wsCloseClients();
     // a spiffs binary must have 'spiffs' in the filename
     int cmd = (strstr(inFileName, "spiffs") != NULL) ? U_SPIFFS : U_FLASH;
     if (cmd == U_SPIFFS) STORAGE.end(); // close relevant file system
@@ -425,22 +569,235 @@ static esp_err_t sendCrossOriginHeader(httpd_req_t *req) {
   return ESP_OK;
 }
 
-bool wsAsyncSendText(const char* wsData) {
-  // websockets send text function, used for async logging and status updates
-  if (fdWs >= 0) {
-    // send if connection active
-    httpd_ws_frame_t wsPkt;
-    wsPkt.payload = (uint8_t*)wsData;
-    wsPkt.len = strlen(wsData);
-    wsPkt.type = HTTPD_WS_TYPE_TEXT;
-    wsPkt.final = true;
-    esp_err_t ret = httpd_ws_send_frame_async(httpServer, fdWs, &wsPkt);
-    if (ret != ESP_OK) LOG_WRN("websocket send failed with %s", esp_err_to_name(ret));
-    return ret == ESP_OK ? true : false;
-  } 
+/********************* websocket send queue **********************/
+
+// Frames are copied into a ring of preallocated slots and sent by wsSendTask, so
+// that callers such as the audio task never wait on TCP.
+// Up to WS_CLIENTS websockets can be connected, each subscribed to a set of topics.
+// Each frame is copied once, tagged with the clients subscribed to its topic, and
+// counts down as it is sent to each client, its slot being reused when all are done.
+// Each client has its own read position, and clients are served in turn.
+// If the ring is full the oldest queued frame is dropped.
+// Consecutive binary frames queued with merge set are coalesced into one frame of
+// up to WS_MERGE_LEN bytes, if not yet sent to any client.
+
+struct wsFrame {
+  uint8_t data[WS_FRAME_LEN];
+  size_t len;
+  httpd_ws_type_t type;
+  uint8_t topic;
+  uint8_t clients; // bit per client still to be sent frame
+  bool merge;
+  bool started; // sent to at least one client
+};
+
+struct wsClient {
+  int fd; // -1 if slot unused
+  uint8_t topics; // subscribed topics
+  uint32_t nextSeq; // next frame to check for sending
+  uint32_t since; // when connected
+  uint32_t sent; // frames sent to client
+  uint32_t dropped; // frames skipped as client behind oldest queued
+};
+
+static wsFrame* wsRing = NULL;
+static uint8_t* wsSendBuff = NULL; // frame being sent, so ring is not held during send
+static uint32_t wsHeadSeq = 0; // oldest queued frame
+static uint32_t wsTailSeq = 0; // next frame to be queued
+static wsClient wsClients[WS_CLIENTS];
+static portMUX_TYPE wsMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t wsSendHandle = NULL;
+static uint32_t wsSent = 0, wsMerged = 0, wsQDropped = 0, wsFailed = 0, wsMaxDepth = 0;
+static const char* wsTopicNames[] = {"audio", "spectrum", "log", "status"};
+
+static inline wsFrame* wsSlot(uint32_t seq) {
+  return &wsRing[seq % WS_QUEUE_LEN];
+}
+
+static void wsReleaseHead() {
+  // reuse slots at head of ring no longer needed by any client, called under lock
+  while (wsHeadSeq != wsTailSeq && !wsSlot(wsHeadSeq)->clients) wsHeadSeq++;
+}
+
+static void wsRemoveClient(int c) {
+  // release client slot and its claim on queued frames, called under lock
+  uint32_t seq = (int32_t)(wsClients[c].nextSeq - wsHeadSeq) < 0 ? wsHeadSeq : wsClients[c].nextSeq;
+  for (; seq != wsTailSeq; seq++) wsSlot(seq)->clients &= ~(1 << c);
+  wsClients[c].fd = -1;
+  wsClients[c].topics = 0;
+  wsReleaseHead();
+}
+
+static int wsFindClient(int fd) {
+  for (int c = 0; c < WS_CLIENTS; c++) if (wsClients[c].fd == fd) return c;
+  return -1;
+}
+
+static bool wsNextFrame(int c, httpd_ws_frame_t* wsPkt) {
+  // copy next frame for client to send buffer, false if none
+  bool found = false;
+  portENTER_CRITICAL(&wsMux);
+  wsClient* client = &wsClients[c];
+  if (client->fd >= 0) {
+    if ((int32_t)(client->nextSeq - wsHeadSeq) < 0) {
+      // skip dropped frames
+      client->dropped += wsHeadSeq - client->nextSeq;
+      client->nextSeq = wsHeadSeq;
+    }
+    for (; client->nextSeq != wsTailSeq && !found; client->nextSeq++) {
+      wsFrame* frame = wsSlot(client->nextSeq);
+      if (frame->clients & (1 << c)) {
+        memcpy(wsSendBuff, frame->data, frame->len);
+        memset(wsPkt, 0, sizeof(httpd_ws_frame_t));
+        wsPkt->payload = wsSendBuff;
+        wsPkt->len = frame->len;
+        wsPkt->type = frame->type;
+        wsPkt->final = true;
+        frame->clients &= ~(1 << c);
+        frame->started = true;
+        found = true;
+      }
+    }
+    wsReleaseHead();
+  }
+  portEXIT_CRITICAL(&wsMux);
+  return found;
+}
+
+static void wsSendTask(void* arg) {
+  // send queued frames to each client in turn
+  // a client that cannot take a frame within WS_SEND_TIMEOUT is closed, so that
+  // it only holds up sending to other clients briefly
+  httpd_ws_frame_t wsPkt;
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    bool sending = true;
+    while (sending) {
+      sending = false;
+      for (int c = 0; c < WS_CLIENTS; c++) {
+        if (!wsNextFrame(c, &wsPkt)) continue;
+        sending = true;
+        int fd = wsClients[c].fd;
+        TRACE_BEGIN(trc_ws_send);
+        // socket may have been closed and reused for http
+        bool isWs = fd >= 0 && httpd_ws_get_fd_info(httpServer, fd) == HTTPD_WS_CLIENT_WEBSOCKET;
+        esp_err_t ret = isWs ? httpd_ws_send_frame_async(httpServer, fd, &wsPkt) : ESP_FAIL;
+        TRACE_END(trc_ws_send);
+        if (ret == ESP_OK) {
+          wsSent++;
+          wsClients[c].sent++;
+        } else {
+          // client gone or too slow
+          portENTER_CRITICAL(&wsMux);
+          if (wsClients[c].fd == fd) wsRemoveClient(c);
+          portEXIT_CRITICAL(&wsMux);
+          if (isWs) httpd_sess_trigger_close(httpServer, fd); // frame may be partly sent
+          if (wsFailed++ % 100 == 0) LOG_WRN("websocket send failed with %s", esp_err_to_name(ret)); // limit log recursion
+        }
+      }
+    }
+  }
+}
+
+static bool wsQueueFrame(const uint8_t* data, size_t len, httpd_ws_type_t type, uint8_t topic, bool merge) {
+  // copy frame to ring for sending by wsSendTask to subscribed clients, never blocks
+  if (wsRing == NULL) return false;
+  if (len > WS_FRAME_LEN) {
+    wsFailed++;
+    return false;
+  }
+  portENTER_CRITICAL(&wsMux);
+  uint8_t clients = 0;
+  for (int c = 0; c < WS_CLIENTS; c++) if (wsClients[c].fd >= 0 && (wsClients[c].topics & topic)) clients |= 1 << c;
+  if (!clients) {
+    portEXIT_CRITICAL(&wsMux);
+    return false;
+  }
+  wsFrame* last = wsHeadSeq != wsTailSeq ? wsSlot(wsTailSeq - 1) : NULL;
+  if (merge && last != NULL && last->merge && !last->started && last->topic == topic 
+      && last->clients == clients && last->len + len <= WS_MERGE_LEN) {
+    // append to newest queued frame
+    memcpy(last->data + last->len, data, len);
+    last->len += len;
+    wsMerged++;
+  } else {
+    if (wsTailSeq - wsHeadSeq == WS_QUEUE_LEN) {
+      // drop oldest, clients skip it as behind head
+      wsHeadSeq++;
+      wsQDropped++;
+      wsReleaseHead();
+    }
+    wsFrame* frame = wsSlot(wsTailSeq++);
+    memcpy(frame->data, data, len);
+    frame->len = len;
+    frame->type = type;
+    frame->topic = topic;
+    frame->clients = clients;
+    frame->merge = merge;
+    frame->started = false;
+    if (wsTailSeq - wsHeadSeq > wsMaxDepth) wsMaxDepth = wsTailSeq - wsHeadSeq;
+  }
+  portEXIT_CRITICAL(&wsMux);
+  xTaskNotifyGive(wsSendHandle);
+  return true;
+}
+
+static void startWsQueue() {
+  // slots in internal RAM so copying under lock is quick
+  if (wsRing != NULL) return;
+  for (int c = 0; c < WS_CLIENTS; c++) wsClients[c].fd = -1;
+  wsRing = (wsFrame*)heap_caps_malloc(WS_QUEUE_LEN * sizeof(wsFrame), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  wsSendBuff = (uint8_t*)malloc(WS_FRAME_LEN);
+  if (wsRing == NULL || wsSendBuff == NULL) {
+    LOG_ERR("Insufficient memory for websocket queue");
+    free(wsRing);
+    free(wsSendBuff);
+    wsRing = NULL;
+    return;
+  }
+  xTaskCreate(wsSendTask, "wsSendTask", WS_STACK_SIZE, NULL, WS_PRI, &wsSendHandle);
+}
+
+size_t wsQueueStats(char* p) {
+  // websocket queue counters as json for web page
+  int clientCnt = 0;
+  for (int c = 0; c < WS_CLIENTS; c++) if (wsClients[c].fd >= 0) clientCnt++;
+  size_t len = sprintf(p, "\"WSqueue\":\"clients %d/%d, sent %lu, merged %lu, dropped %lu, failed %lu, max depth %lu/%d, per client sent/dropped:", 
+    clientCnt, WS_CLIENTS, wsSent, wsMerged, wsQDropped, wsFailed, wsMaxDepth, WS_QUEUE_LEN);
+  for (int c = 0; c < WS_CLIENTS; c++) 
+    if (wsClients[c].fd >= 0) len += sprintf(p + len, " %d=%lu/%lu", wsClients[c].fd, wsClients[c].sent, wsClients[c].dropped);
+  return len + sprintf(p + len, "\",");
+}
+
+bool wsSubscribed(uint8_t topic) {
+  // whether any client subscribed to topic
+  for (int c = 0; c < WS_CLIENTS; c++) if (wsClients[c].fd >= 0 && (wsClients[c].topics & topic)) return true;
   return false;
 }
 
+static void wsSubscribe(int fd, const char* wsMsg) {
+  // browser message +<topic> or -<topic> to subscribe or unsubscribe
+  for (int t = 0; t < sizeof(wsTopicNames) / sizeof(wsTopicNames[0]); t++) {
+    if (!strcmp(wsMsg + 1, wsTopicNames[t])) {
+      portENTER_CRITICAL(&wsMux);
+      int c = wsFindClient(fd);
+      if (c >= 0) {
+        if (wsMsg[0] == '+') wsClients[c].topics |= 1 << t;
+        else wsClients[c].topics &= ~(1 << t);
+      }
+      portEXIT_CRITICAL(&wsMux);
+      LOG_VRB("Websocket %d %s %s", fd, wsMsg[0] == '+' ? "subscribed to" : "unsubscribed from", wsMsg + 1);
+      return;
+    }
+  }
+  LOG_WRN("Unknown websocket topic %s", wsMsg + 1);
+}
+
+bool wsAsyncSendText(const char* wsData, uint8_t topic) {
+  // websockets send text function, used for async logging and status updates
+  return wsQueueFrame((const uint8_t*)wsData, strlen(wsData), HTTPD_WS_TYPE_TEXT, topic, false);
+}
+
 bool wsAsyncSendJson(const char* dataType, const char* wsData) {
   // build json to send
   char wsJson[strlen(dataType) + strlen(wsData) + 30];
@@ -448,44 +805,65 @@ bool wsAsyncSendJson(const char* dataType, const char* wsData) {
   return wsAsyncSendText(wsJson);
 }
 
-void wsAsyncSendBinary(uint8_t* data, size_t len) {
+void wsAsyncSendBinary(uint8_t* data, size_t len, bool merge, uint8_t topic) {
   // websockets send binary function, used for app specific features
-  if (fdWs >= 0) {
-    if (data == NULL || len == 0) {
-      LOG_WRN("Invalid data or length: data=%p, len=%u", data, len);
-      return;
-    }
-    // send if connection active
-    httpd_ws_frame_t wsPkt;
-    memset(&wsPkt, 0, sizeof(httpd_ws_frame_t)); // Initialize all fields to zero
-    wsPkt.type = HTTPD_WS_TYPE_BINARY;
-    wsPkt.payload = data;
-    wsPkt.len = len;
-    esp_err_t ret = httpd_ws_send_frame_async(httpServer, fdWs, &wsPkt);
-    if (ret != ESP_OK) LOG_WRN("websocket send failed with %s", esp_err_to_name(ret));
-  } // else ignore
+  // merge allows coalescing with previous queued frame, eg for raw audio
+  if (data == NULL || len == 0) {
+    LOG_WRN("Invalid data or length: data=%p, len=%u", data, len);
+    return;
+  }
+  wsQueueFrame(data, len, HTTPD_WS_TYPE_BINARY, topic, merge);
+}
+
+static void wsAddClient(int fd) {
+  // new websocket connection, replacing oldest if all slots in use
+  portENTER_CRITICAL(&wsMux);
+  int c = wsFindClient(fd);
+  if (c < 0) c = wsFindClient(-1);
+  int oldFd = -1;
+  if (c < 0) {
+    c = 0;
+    for (int i = 1; i < WS_CLIENTS; i++) if ((int32_t)(wsClients[i].since - wsClients[c].since) < 0) c = i;
+    oldFd = wsClients[c].fd;
+    wsRemoveClient(c);
+  }
+  wsClients[c].fd = fd;
+  wsClients[c].topics = WS_DEFAULT_TOPICS;
+  wsClients[c].nextSeq = wsTailSeq;
+  wsClients[c].since = millis();
+  wsClients[c].sent = wsClients[c].dropped = 0;
+  portEXIT_CRITICAL(&wsMux);
+  struct timeval sendTimeout = {0, WS_SEND_TIMEOUT * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+  if (oldFd >= 0) {
+    LOG_VRB("closing connection %d, as max websockets connected", oldFd);
+    httpd_sess_trigger_close(httpServer, oldFd);
+  }
+  LOG_VRB("Websocket connection: %d", fd);
+}
+
+static void wsCloseClients() {
+  // close all websocket connections
+  for (int c = 0; c < WS_CLIENTS; c++) {
+    portENTER_CRITICAL(&wsMux);
+    int fd = wsClients[c].fd;
+    if (fd >= 0) wsRemoveClient(c);
+    portEXIT_CRITICAL(&wsMux);
+    if (fd >= 0) httpd_sess_trigger_close(httpServer, fd);
+  }
 }
 
 static esp_err_t wsHandler(httpd_req_t *req) {
   // receive websocket data and determine response
-  // if a new connection is received, the old connection is closed, but the browser
-  // page on the newer connection may need to be manually refreshed to take over the log
+  // up to WS_CLIENTS connections are served, if another connects the oldest is closed
   esp_err_t ret = ESP_OK;
   if (req->method == HTTP_GET) {
     // websocket connection request from browser client
-    if (fdWs != -1) {
-      if (fdWs != httpd_req_to_sockfd(req)) {
-        // websocket connection from browser when another browser connection is active
-        LOG_VRB("closing connection, as newer Websocket on %u", httpd_req_to_sockfd(req));
-        // kill older connection
-        killSocket();
-      }
-    }
-    fdWs = httpd_req_to_sockfd(req);
-    if (fdWs < 0) {
+    int fd = httpd_req_to_sockfd(req);
+    if (fd < 0) {
       LOG_WRN("failed to get socket number");
       ret = ESP_FAIL;
-    } else LOG_VRB("Websocket connection: %d", fdWs);
+    } else wsAddClient(fd);
   } else {
     // data content received
     httpd_ws_frame_t wsPkt;
@@ -494,23 +872,29 @@ static esp_err_t wsHandler(httpd_req_t *req) {
     wsPkt.payload = wsMsg;
     ret = httpd_ws_recv_frame(req, &wsPkt, MAX_PAYLOAD_LEN); 
     if (ret == ESP_OK) {
+      TRACE_BEGIN(trc_ws_recv);
       if (wsPkt.len >= MAX_PAYLOAD_LEN) LOG_ERR("websocket payload too long %d", wsPkt.len);
       wsMsg[wsPkt.len] = 0; // terminator
       if (wsPkt.type == HTTPD_WS_TYPE_BINARY && wsPkt.len) appSpecificWsBinHandler(wsMsg, wsPkt.len);
+      else if (wsPkt.type == HTTPD_WS_TYPE_TEXT && (wsMsg[0] == '+' || wsMsg[0] == '-')) wsSubscribe(httpd_req_to_sockfd(req), (const char*)wsMsg);
       else if (wsPkt.type == HTTPD_WS_TYPE_TEXT) appSpecificWsHandler((const char*)wsMsg);
-      else if (wsPkt.type == HTTPD_WS_TYPE_CLOSE) appSpecificWsHandler("X");
+      else if (wsPkt.type == HTTPD_WS_TYPE_CLOSE) {
+        portENTER_CRITICAL(&wsMux);
+        int c = wsFindClient(httpd_req_to_sockfd(req));
+        if (c >= 0) wsRemoveClient(c);
+        portEXIT_CRITICAL(&wsMux);
+        appSpecificWsHandler("X");
+      }
+      TRACE_END(trc_ws_recv);
     } else LOG_ERR("websocket receive failed with %s", esp_err_to_name(ret));
   }
   return ret;
 }
 
 void killSocket(int skt) {
-  // user requested
-  if (skt == -99) {
-    skt = fdWs;
-    fdWs = -1;
-  }
-  if (skt >= 0) httpd_sess_trigger_close(httpServer, skt);
+  // user requested, -99 for all websockets
+  if (skt == -99) wsCloseClients();
+  else if (skt >= 0) httpd_sess_trigger_close(httpServer, skt);
 }
 
 /*
@@ -581,6 +965,11 @@ bool startWebServer() {
   httpd_uri_t wsUri = {.uri = "/ws", .method = HTTP_GET, .handler = wsHandler, .user_ctx = NULL, .is_websocket = true};
   httpd_uri_t sustainUri = {.uri = "/sustain", .method = HTTP_GET, .handler = appSpecificSustainHandler, .user_ctx = NULL};
   httpd_uri_t checkUri = {.uri = "/sustain", .method = HTTP_HEAD, .handler = appSpecificSustainHandler, .user_ctx = NULL};
+#ifdef ISVC
+  httpd_uri_t streamUri = {.uri = "/stream.wav", .method = HTTP_GET, .handler = streamHandler, .user_ctx = NULL};
+  httpd_uri_t processUri = {.uri = "/process", .method = HTTP_POST, .handler = processHandler, .user_ctx = NULL};
+  httpd_uri_t importUri = {.uri = "/import", .method = HTTP_POST, .handler = importHandler, .user_ctx = NULL};
+#endif
 
   if (res == ESP_OK) {
     httpd_register_uri_handler(httpServer, &indexUri);
@@ -594,7 +983,13 @@ bool startWebServer() {
     httpd_register_uri_handler(httpServer, &wsUri);
     httpd_register_uri_handler(httpServer, &sustainUri);
     httpd_register_uri_handler(httpServer, &checkUri);
+#ifdef ISVC
+    httpd_register_uri_handler(httpServer, &streamUri);
+    httpd_register_uri_handler(httpServer, &processUri);
+    httpd_register_uri_handler(httpServer, &importUri);
+#endif
     httpd_register_err_handler(httpServer, HTTPD_404_NOT_FOUND, customOrNotFoundHandler);
+    startWsQueue();
 
     LOG_INF("Starting web server on port: %u", useHttps ? HTTPS_PORT : HTTP_PORT);
     LOG_INF("Remote server certificates %s checked", useSecure ? "are" : "not");